@@ -2,7 +2,7 @@
 
 usage()
 {
-	echo "usage: ./build.sh M T G [-odir output-dir] [--search/--painter/--rooster/--kibbitzer/--minitools/--tests] [--debug] [--older]"
+	echo "usage: ./build.sh M T G [-odir output-dir] [--search/--painter/--rooster/--kibbitzer/--minitools/--tests] [--debug] [--older] [--dfpn] [--local]"
 	echo "where M: the number of bins/machines (e.g. 6)"
 	echo "      T: the allowed load of bins (e.g. 19)"
 	echo "      G: the optimal maximum load of all bins (e.g. 14)"
@@ -30,6 +30,9 @@ BUILDING_TESTS=true
 CPP_STANDARD="c++2a"
 LINKING_SUFFIX=""
 OPTFLAG="-O3"
+SEARCH_DEFINES=""
+SEARCH_SUFFIX=""
+SEARCH_COMPILER="mpic++"
 
 # Skip first three parameters, then iterate over the rest of the arguments.
 shift 3
@@ -100,6 +103,18 @@ while (( "$#" )); do
 	    OPTFLAG="-O3 -g"
 	    shift
 	    ;;
+	--dfpn)
+	    SEARCH_DEFINES="$SEARCH_DEFINES -DDFPN"
+	    SEARCH_SUFFIX="$SEARCH_SUFFIX-dfpn"
+	    shift
+	    ;;
+	--local)
+	    # The queen and one overseer run as threads of a single process, without MPI.
+	    SEARCH_DEFINES="$SEARCH_DEFINES -DLOCAL"
+	    SEARCH_SUFFIX="$SEARCH_SUFFIX-local"
+	    SEARCH_COMPILER="g++"
+	    shift
+	    ;;
 	*) # unsupported flags
 	    echo "Error: Unsupported flag $1" >&2
 	    usage
@@ -121,8 +136,8 @@ fi
 
 
 if [[ "$BUILDING_SEARCH" = true ]]; then
-	echo "Running: mpic++ -I./ -Wall -std=$CPP_STANDARD $OPTFLAG -march=native -DIBINS=$BINS -DIR=$R -DIS=$S -DII_S=$I_S main.cpp -o ../$OUTPUT/search-$BINS-$R-$S -pthread $LINKING_SUFFIX"
-	cd search; mpic++ -I./ -Wall -std=$CPP_STANDARD $OPTFLAG -march=native -DIBINS=$BINS -DIR=$R -DIS=$S -DII_S=$I_S main.cpp -o ../$OUTPUT/search-$BINS-$R-$S -pthread $LINKING_SUFFIX; cd ..
+	echo "Running: $SEARCH_COMPILER -I./ -Wall -std=$CPP_STANDARD $OPTFLAG -march=native -DIBINS=$BINS -DIR=$R -DIS=$S -DII_S=$I_S$SEARCH_DEFINES main.cpp -o ../$OUTPUT/search-$BINS-$R-$S$SEARCH_SUFFIX -pthread $LINKING_SUFFIX"
+	cd search; $SEARCH_COMPILER -I./ -Wall -std=$CPP_STANDARD $OPTFLAG -march=native -DIBINS=$BINS -DIR=$R -DIS=$S -DII_S=$I_S$SEARCH_DEFINES main.cpp -o ../$OUTPUT/search-$BINS-$R-$S$SEARCH_SUFFIX -pthread $LINKING_SUFFIX; cd ..
 fi
 
 if [[ "$BUILDING_PAINTER" = true ]]; then
@@ -145,6 +160,8 @@ if [[ "$BUILDING_MINITOOLS" = true ]]; then
 	cd minitools; g++ -I../search/ -Wall -std=$CPP_STANDARD $OPTFLAG -march=native -DIBINS=$BINS -DIR=$R -DIS=$S -DII_S=$I_S listsaplings.cpp -o ../$OUTPUT/listsaplings-$BINS-$R-$S -pthread $LINKING_SUFFIX; cd ..
 	echo "Running: g++ -Wall -std=$CPP_STANDARD $OPTFLAG -march=native minitools/alg-winning-table.cpp -o ./$OUTPUT/awt -pthread"
 	g++ -I./search/ -Wall -std=$CPP_STANDARD $OPTFLAG -march=native minitools/alg-winning-table.cpp -o ./$OUTPUT/awt -pthread
+	echo "Running: g++ -Wall -std=$CPP_STANDARD $OPTFLAG -march=native -DIBINS=$BINS -DIR=$R -DIS=$S -DII_S=$I_S tablebase.cpp -o ../$OUTPUT/tablebase-$BINS-$R-$S -pthread $LINKING_SUFFIX"
+	cd minitools; g++ -I../search/ -Wall -std=$CPP_STANDARD $OPTFLAG -march=native -DIBINS=$BINS -DIR=$R -DIS=$S -DII_S=$I_S tablebase.cpp -o ../$OUTPUT/tablebase-$BINS-$R-$S -pthread $LINKING_SUFFIX; cd ..
 
 fi
 
@@ -0,0 +1,53 @@
+// Builds the endgame tablebase for the compiled BINS, R, S and monotonicity
+// and stores it into ./cache/, where the overseers look for it.
+
+// Usage: ./tablebase-M-T-G [--volume V] [--threads T]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "../search/common.hpp"
+#include "../search/hash.hpp"
+#include "../search/binconf.hpp"
+#include "../search/filetools.hpp"
+#include "../search/tablebase.hpp"
+
+int main(int argc, char **argv)
+{
+    int volume = TABLEBASE_VOLUME;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; i++)
+    {
+	if (strcmp(argv[i], "--volume") == 0 && i < argc - 1)
+	{
+	    volume = atoi(argv[++i]);
+	} else if (strcmp(argv[i], "--threads") == 0 && i < argc - 1)
+	{
+	    threads = atoi(argv[++i]);
+	} else
+	{
+	    fprintf(stderr, "Usage: %s [--volume V] [--threads T]\n", argv[0]);
+	    return -1;
+	}
+    }
+
+    if (volume <= 0 || threads <= 0)
+    {
+	fprintf(stderr, "The volume and the number of threads must be positive.\n");
+	return -1;
+    }
+
+    zobrist_init();
+    folder_checks();
+
+    fprintf(stderr, "Building the endgame tablebase for %d bins, ratio %d/%d, monotonicity %d and remaining volume %d.\n",
+	    BINS, R, S, monotonicity, volume);
+    endgame_tablebase tablebase(volume);
+    tablebase.build(threads);
+    tablebase.backup();
+    fprintf(stderr, "Tablebase stored into %s.\n", tablebase.storage_file_path);
+    return 0;
+}
@@ -0,0 +1,267 @@
+#ifndef _AUTOTUNING_HPP
+#define _AUTOTUNING_HPP 1
+
+// Choosing the task bounds of a sapling at runtime. Too small bounds leave the overseers
+// without work, too large ones flood the queen with millions of tiny tasks.
+
+// The autotuner estimates, for each candidate pair of bounds, how many tasks the generation
+// of the sapling would produce, by random probes in the style of Knuth: a probe walks from the
+// sapling down the game tree, picking a random item for the adversary and a random bin for
+// the algorithm, and the product of the numbers of choices along the walk is an unbiased
+// estimate of the number of vertices at that depth. Summed up at the first vertex where
+// POSSIBLE_TASK holds, it estimates the number of tasks.
+
+// The estimate ignores the positions shared in the DAG and the pruning by heuristics,
+// so it is an upper bound rather than a precise count. After each round, the estimates are
+// compared with the number of tasks actually generated, and the ratio corrects the estimates
+// for the following saplings. If the task cost model is trained, the expected running time
+// of a task is estimated by the probes as well.
+
+#include <cinttypes>
+#include <cmath>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "common.hpp"
+#include "binconf.hpp"
+#include "dag/dag.hpp"
+#include "dynprog/algo.hpp"
+#include "saplings.hpp"
+#include "tasks.hpp"
+#include "task_cost.hpp"
+
+class task_autotuner
+{
+public:
+    // The candidate depths are the even ones up to MAX_DEPTH (calls, two per item).
+    static constexpr int MAX_DEPTH = 24;
+
+    const task_cost_model *cost_model = nullptr;
+    dynprog_data dpdata;
+
+    struct tuning
+    {
+	task_bounds bounds;
+	double estimated_tasks = 0.0;
+    };
+
+    // The bounds are computed once per sapling and regrow level, so that the same
+    // sapling is always generated the same way (the pipelining relies on it).
+    std::unordered_map<uint64_t, tuning> tuned;
+
+    // The ratio of generated to estimated tasks in the last round.
+    double correction = 1.0;
+
+    task_autotuner(const task_cost_model *model) : cost_model(model)
+	{
+	}
+
+    void tune(sapling &job);
+    void calibrate(const std::vector<sapling> &jobs, int generated_tasks);
+
+private:
+    struct probe_step
+    {
+	binconf bc;
+	int calldepth = 0;
+	int largest_item = 0;
+	double weight = 1.0;
+	double seconds = -1.0; // Predicted running time of a task here, computed lazily.
+    };
+
+    static uint64_t key(const sapling &job)
+	{
+	    return job.root->bc.hash_with_last() ^ (uint64_t) job.regrow_level;
+	}
+
+    void probe(const binconf &root, std::mt19937_64 &rng, std::vector<probe_step> &path);
+    double predicted_seconds(probe_step &step);
+};
+
+// One random walk from the root to a vertex where the game ends.
+void task_autotuner::probe(const binconf &root, std::mt19937_64 &rng, std::vector<probe_step> &path)
+{
+    path.clear();
+    probe_step current;
+    current.bc = root;
+
+    while (true)
+    {
+	path.push_back(current);
+
+	bin_int low = lowest_sendable(current.bc.last_item);
+	// The dynamic programming needs an item larger than one; items of size one fit anywhere.
+	bin_int maximum_feasible = std::min(S, S*BINS - current.bc.totalload());
+	if (current.bc.itemcount() > current.bc.items[1])
+	{
+	    maximum_feasible = dynprog_max_direct<false>(current.bc, &dpdata);
+	}
+
+	if (maximum_feasible < low)
+	{
+	    return;
+	}
+
+	std::uniform_int_distribution<int> item_choice(low, maximum_feasible);
+	int item = item_choice(rng);
+
+	// Bins of equal load lead to the same position.
+	std::vector<int> bins;
+	for (int i = 1; i <= BINS; i++)
+	{
+	    if (current.bc.loads[i] + item < R && (i == 1 || current.bc.loads[i] != current.bc.loads[i-1]))
+	    {
+		bins.push_back(i);
+	    }
+	}
+
+	if (bins.empty())
+	{
+	    return;
+	}
+
+	std::uniform_int_distribution<int> bin_choice(0, bins.size() - 1);
+	current.bc.assign_and_rehash(item, bins[bin_choice(rng)]);
+	current.weight *= (maximum_feasible - low + 1) * bins.size();
+	current.calldepth += 2;
+	current.largest_item = std::max(current.largest_item, item);
+	current.seconds = -1.0;
+    }
+}
+
+double task_autotuner::predicted_seconds(probe_step &step)
+{
+    if (step.seconds < 0.0)
+    {
+	step.seconds = std::exp(cost_model->predict(task(step.bc)));
+    }
+    return step.seconds;
+}
+
+// Sets the tuned bounds of the job. Without any task in the probes, the job keeps its bounds.
+void task_autotuner::tune(sapling &job)
+{
+    task_bounds base = job.bounds();
+    auto it = tuned.find(key(job));
+    if (it != tuned.end())
+    {
+	job.tuned_bounds = it->second.bounds;
+	return;
+    }
+
+    if (job.regrow_level > REGROW_LIMIT)
+    {
+	tuned[key(job)] = {base, 0.0};
+	job.tuned_bounds = base;
+	return;
+    }
+
+    std::vector<task_bounds> candidates;
+    for (int depth = 2; depth <= MAX_DEPTH; depth += 2)
+    {
+	for (int load = 1; load <= S*BINS - base.root_load; load++)
+	{
+	    candidates.push_back(task_bounds{depth, load, base.root_load});
+	}
+    }
+
+    bool timed = (cost_model != nullptr && cost_model->trained);
+    std::vector<double> task_count(candidates.size(), 0.0);
+    std::vector<double> task_seconds(candidates.size(), 0.0);
+
+    uint64_t seed = AUTOTUNE_SEED ^ job.root->bc.hash_with_last();
+    std::mt19937_64 rng(seed);
+    std::vector<probe_step> path;
+    adversary_vertex probed(job.root->bc, 0, "");
+
+    for (int p = 0; p < AUTOTUNE_PROBES; p++)
+    {
+	probe(job.root->bc, rng, path);
+	for (unsigned int c = 0; c < candidates.size(); c++)
+	{
+	    for (probe_step &step : path)
+	    {
+		probed.bc = step.bc;
+		if (POSSIBLE_TASK(&probed, step.largest_item, step.calldepth, candidates[c]))
+		{
+		    task_count[c] += step.weight;
+		    if (timed)
+		    {
+			task_seconds[c] += step.weight * predicted_seconds(step);
+		    }
+		    break;
+		}
+	    }
+	}
+    }
+
+    // The distance from the targets is measured on the logarithmic scale.
+    int best = -1;
+    double best_error = 0.0;
+    for (unsigned int c = 0; c < candidates.size(); c++)
+    {
+	if (task_count[c] <= 0.0)
+	{
+	    continue;
+	}
+
+	double count = correction * task_count[c] / AUTOTUNE_PROBES;
+	double error = std::fabs(std::log(count / AUTOTUNE_TARGET_TASKS));
+	if (timed)
+	{
+	    error += std::fabs(std::log(task_seconds[c] / task_count[c] / AUTOTUNE_TASK_SECONDS));
+	}
+
+	if (best == -1 || error < best_error)
+	{
+	    best = c;
+	    best_error = error;
+	}
+    }
+
+    task_bounds chosen = base;
+    double estimated_tasks = 0.0;
+    if (best != -1)
+    {
+	chosen = candidates[best];
+	estimated_tasks = task_count[best] / AUTOTUNE_PROBES;
+	print_if<PROGRESS>("Autotuner: %d probes with seed %" PRIu64 " and correction %.4lf chose task depth %d and load %d, estimating %.0lf tasks",
+			   AUTOTUNE_PROBES, seed, correction, chosen.depth, chosen.load, correction * estimated_tasks);
+	if (timed)
+	{
+	    print_if<PROGRESS>(" of %.3lf s each", task_seconds[best] / task_count[best]);
+	}
+	print_if<PROGRESS>(".\n");
+    } else
+    {
+	print_if<PROGRESS>("Autotuner: no tasks found by the probes, keeping task depth %d and load %d.\n",
+			   chosen.depth, chosen.load);
+    }
+
+    tuned[key(job)] = {chosen, estimated_tasks};
+    job.tuned_bounds = chosen;
+}
+
+// Compares the estimates for the saplings of a round with the number of tasks generated for them.
+void task_autotuner::calibrate(const std::vector<sapling> &jobs, int generated_tasks)
+{
+    double estimated_tasks = 0.0;
+    for (const sapling &job : jobs)
+    {
+	auto it = tuned.find(key(job));
+	if (it != tuned.end())
+	{
+	    estimated_tasks += it->second.estimated_tasks;
+	}
+    }
+
+    if (estimated_tasks > 0.0 && generated_tasks > 0)
+    {
+	correction = generated_tasks / estimated_tasks;
+	print_if<VERBOSE>("Autotuner: %d tasks generated, %.0lf estimated, correction set to %.4lf.\n",
+			  generated_tasks, estimated_tasks, correction);
+    }
+}
+
+#endif // _AUTOTUNING_HPP
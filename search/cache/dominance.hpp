@@ -0,0 +1,198 @@
+#include <cstdio>
+#include <atomic>
+
+#include "../common.hpp"
+#include "../hash.hpp"
+
+// A dominance index for adversary positions.
+
+// Adversary positions with the same loads and the same items differ only in the
+// lowest item the adversary is still allowed to send (due to monotonicity).
+// A lower lowest sendable item only gives the adversary more moves. Thus, if the adversary
+// wins with the lowest sendable item l, it also wins for every l' <= l, and if the algorithm
+// wins with l, it also wins for every l' >= l.
+
+// For each pair (loads, items) we keep the largest lowest sendable item proven to be
+// adversary-winning and the smallest one proven to be algorithm-winning. One probe then
+// answers the query for the whole family of positions, while adv_cache only answers
+// for exact matches.
+
+// Note that we do not compare different load vectors of the same items: the loads always
+// sum up to the total size of the items, so no load vector is componentwise above another one.
+
+#ifndef _CACHE_DOMINANCE_HPP
+#define _CACHE_DOMINANCE_HPP 1
+
+// An element of the dominance cache, stored in 64 bits. The upper bits hold
+// the lowest bits of the hash of the loads and items, the lower bits the two thresholds,
+// where zero means that nothing is known.
+
+// The position in the table is given by the highest bits of the hash (see logpart()),
+// so the stored bits must be the lowest ones. Together with the position, they check
+// all 64 bits of the hash once the table has 2^23 elements or more.
+class dominance_el
+{
+public:
+    static constexpr int FIELD_BITS = 10;
+    static constexpr uint64_t FIELD_MASK = (1ULL << FIELD_BITS) - 1;
+    static constexpr int TAG_BITS = 64 - 2*FIELD_BITS;
+    static constexpr uint64_t TAG_MASK = (1ULL << TAG_BITS) - 1;
+    static_assert(S <= FIELD_MASK);
+
+    uint64_t _data = 0;
+
+    inline void set(uint64_t hash, uint64_t adv_low, uint64_t alg_low)
+	{
+	    _data = ((hash & TAG_MASK) << (2*FIELD_BITS)) | (adv_low << FIELD_BITS) | alg_low;
+	}
+
+    // The largest lowest sendable item with a known adversary win.
+    inline int adv_low() const
+	{
+	    return (_data >> FIELD_BITS) & FIELD_MASK;
+	}
+
+    // The smallest lowest sendable item with a known algorithmic win.
+    inline int alg_low() const
+	{
+	    return _data & FIELD_MASK;
+	}
+
+    inline bool match(const uint64_t& hash) const
+	{
+	    return (_data >> (2*FIELD_BITS)) == (hash & TAG_MASK);
+	}
+
+    inline bool empty() const
+	{
+	    return _data == 0;
+	}
+
+    // Merges a new result into the thresholds of the element.
+    void merge(uint64_t hash, int low, victory win)
+	{
+	    int adv = empty() ? 0 : adv_low();
+	    int alg = empty() ? 0 : alg_low();
+
+	    if (win == victory::adv)
+	    {
+		adv = std::max(adv, low);
+	    } else if (win == victory::alg)
+	    {
+		alg = (alg == 0) ? low : std::min(alg, low);
+	    }
+
+	    set(hash, adv, alg);
+	}
+};
+
+class dominance_cache
+{
+public:
+    std::atomic<uint64_t> *ht;
+    uint64_t htsize;
+    int logsize;
+
+    dominance_cache(uint64_t logbytes)
+	{
+	    uint64_t bytes = two_to(logbytes);
+	    const uint64_t megabyte = 1024 * 1024;
+
+	    htsize = power_of_two_below(bytes / sizeof(dominance_el));
+	    logsize = quicklog(htsize);
+	    print_if<PROGRESS>("Given %llu logbytes (%llu MBs), creating dominance cache to %llu els (logsize %llu).\n",
+			       logbytes, bytes/megabyte, htsize, logsize);
+
+	    ht = new std::atomic<uint64_t>[htsize];
+	    for (uint64_t i = 0; i < htsize; i++)
+	    {
+		std::atomic_init(&ht[i], (uint64_t) 0);
+	    }
+	}
+
+    ~dominance_cache()
+	{
+	    delete[] ht;
+	}
+
+    uint64_t trim(uint64_t ha)
+	{
+	    return logpart(ha, logsize);
+	}
+
+    victory lookup(uint64_t h, int low);
+    void insert(uint64_t h, int low, victory win);
+};
+
+victory dominance_cache::lookup(uint64_t h, int low)
+{
+    uint64_t pos = trim(h);
+    for (int i = 0; i < LINPROBE_LIMIT && pos + i < htsize; i++)
+    {
+	dominance_el candidate;
+	candidate._data = ht[pos + i].load(std::memory_order_relaxed);
+
+	if (candidate.empty())
+	{
+	    break;
+	}
+
+	if (candidate.match(h))
+	{
+	    if (candidate.adv_low() != 0 && low <= candidate.adv_low())
+	    {
+		return victory::adv;
+	    }
+
+	    if (candidate.alg_low() != 0 && low >= candidate.alg_low())
+	    {
+		return victory::alg;
+	    }
+
+	    break;
+	}
+    }
+
+    return victory::uncertain;
+}
+
+void dominance_cache::insert(uint64_t h, int low, victory win)
+{
+    uint64_t pos = trim(h);
+    int limit = std::min((uint64_t) LINPROBE_LIMIT, htsize - pos);
+
+    for (int i = 0; i < limit; i++)
+    {
+	uint64_t current = ht[pos + i].load(std::memory_order_relaxed);
+	dominance_el candidate;
+	candidate._data = current;
+
+	if (candidate.empty() || candidate.match(h))
+	{
+	    dominance_el merged = candidate;
+	    merged.merge(h, low, win);
+	    // If another thread wrote into the slot in the meantime, we simply give up.
+	    ht[pos + i].compare_exchange_strong(current, merged._data, std::memory_order_relaxed);
+	    return;
+	}
+    }
+
+    dominance_el fresh;
+    fresh.merge(h, low, win);
+    ht[pos + (rand() % limit)].store(fresh._data, std::memory_order_relaxed);
+}
+
+// Global pointer to the dominance cache.
+dominance_cache *dom_cache = NULL;
+
+victory dominance_lookup(const binconf *d)
+{
+    return dom_cache->lookup(d->loaditemhash(), lowest_sendable(d->last_item));
+}
+
+void dominance_encache(const binconf *d, victory win)
+{
+    dom_cache->insert(d->loaditemhash(), lowest_sendable(d->last_item), win);
+}
+
+#endif // _CACHE_DOMINANCE_HPP
@@ -0,0 +1,438 @@
+#ifndef _CHECKPOINT_HPP
+#define _CHECKPOINT_HPP 1
+
+// Checkpoints of the queen, so that a long computation can be resumed (with --resume)
+// after the queen dies.
+
+// A checkpoint consists of two files in ./cache/. The DAG file holds the DAG at the
+// start of the current round, along with the counters of the queen. The tasks file holds
+// the tasks solved so far in that round; it is rewritten every CHECKPOINT_PERIOD seconds.
+
+// A resumed computation starts the round again, from the stored DAG. The generation
+// produces the same tasks, and those solved before are marked as such before the round
+// starts, so that only the unsolved tasks are sent to the overseers. The tasks are matched
+// by their bin configurations, so a task which is not generated again is simply skipped.
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <filesystem>
+
+#include "common.hpp"
+#include "binconf.hpp"
+#include "dag/dag.hpp"
+#include "tasks.hpp"
+
+// The part of the state of the queen which is not stored in the DAG.
+struct queen_counters
+{
+    int round = 0;
+    int winning_saplings = 0;
+    bool evaluation = true;
+    bool expansion = false;
+};
+
+class checkpoint
+{
+public:
+    static constexpr int VERSION = 1;
+    char dag_file_path[256];
+    char tasks_file_path[256];
+    std::chrono::time_point<std::chrono::steady_clock> last_save;
+
+    // The tasks solved in the round being resumed, indexed by hash_with_last().
+    std::unordered_map<uint64_t, task_status> resumed_solutions;
+    int resumed_round = -1;
+
+    checkpoint()
+	{
+	    sprintf(dag_file_path, "./cache/checkpoint-%d-%d-%d-mon-%d-dag.bin", BINS, R, S, monotonicity);
+	    sprintf(tasks_file_path, "./cache/checkpoint-%d-%d-%d-mon-%d-tasks.bin", BINS, R, S, monotonicity);
+	    last_save = std::chrono::steady_clock::now();
+	}
+
+    bool exists()
+	{
+	    return std::filesystem::exists(dag_file_path);
+	}
+
+    // --- Reading and writing of single values. ---
+
+    template <class T> void write_value(FILE *f, const T& value)
+	{
+	    fwrite(&value, sizeof(T), 1, f);
+	}
+
+    template <class T> bool read_value(FILE *f, T& value)
+	{
+	    return fread(&value, sizeof(T), 1, f) == 1;
+	}
+
+    void write_string(FILE *f, const std::string& s)
+	{
+	    write_value(f, (uint32_t) s.size());
+	    fwrite(s.data(), sizeof(char), s.size(), f);
+	}
+
+    bool read_string(FILE *f, std::string& s)
+	{
+	    uint32_t len = 0;
+	    if (!read_value(f, len))
+	    {
+		return false;
+	    }
+	    s.assign(len, '\0');
+	    return fread(s.data(), sizeof(char), len, f) == len;
+	}
+
+    void write_binconf(FILE *f, const binconf& b)
+	{
+	    fwrite(b.loads.data(), sizeof(bin_int), BINS+1, f);
+	    fwrite(b.items.data(), sizeof(bin_int), S+1, f);
+	    write_value(f, b.last_item);
+	}
+
+    bool read_binconf(FILE *f, binconf& b)
+	{
+	    std::array<bin_int, BINS+1> loads = {};
+	    std::array<bin_int, S+1> items = {};
+	    bin_int last_item = 1;
+	    bool ret = fread(loads.data(), sizeof(bin_int), BINS+1, f) == BINS+1
+		&& fread(items.data(), sizeof(bin_int), S+1, f) == S+1
+		&& read_value(f, last_item);
+	    b = binconf(loads, items, last_item);
+	    return ret;
+	}
+
+    void write_signature(FILE *f, int round)
+	{
+	    int signature[5] = {BINS, R, S, monotonicity, VERSION};
+	    fwrite(signature, sizeof(int), 5, f);
+	    write_value(f, round);
+	}
+
+    bool check_signature(FILE *f, int& round)
+	{
+	    int signature[5] = {};
+	    int expected_signature[5] = {BINS, R, S, monotonicity, VERSION};
+	    return fread(signature, sizeof(int), 5, f) == 5
+		&& std::equal(signature, signature + 5, expected_signature)
+		&& read_value(f, round);
+	}
+
+    // The file is written under a temporary name first, so that a crash during
+    // the writing does not destroy the previous checkpoint.
+    FILE* open_for_writing(const char *path)
+	{
+	    std::string temporary = std::string(path) + ".tmp";
+	    FILE *f = fopen(temporary.c_str(), "wb");
+	    assert(f != nullptr);
+	    return f;
+	}
+
+    void close_and_replace(FILE *f, const char *path)
+	{
+	    fclose(f);
+	    std::filesystem::rename(std::string(path) + ".tmp", path);
+	}
+
+    void save_dag(dag *d, const queen_counters& counters);
+    dag* load_dag(queen_counters& counters);
+    void save_solutions(int round);
+    void load_solutions();
+    int apply_solutions(int round);
+    void remove();
+
+    bool due()
+	{
+	    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - last_save;
+	    return elapsed.count() >= CHECKPOINT_PERIOD;
+	}
+};
+
+void checkpoint::save_dag(dag *d, const queen_counters& counters)
+{
+    FILE *f = open_for_writing(dag_file_path);
+    write_signature(f, counters.round);
+    write_value(f, counters.winning_saplings);
+    write_value(f, counters.evaluation);
+    write_value(f, counters.expansion);
+    write_value(f, d->root->id);
+
+    write_value(f, (uint64_t) d->adv_by_id.size());
+    for (const auto& [id, v] : d->adv_by_id)
+    {
+	write_value(f, id);
+	write_binconf(f, v->bc);
+	write_value(f, v->state);
+	write_value(f, v->win);
+	write_value(f, v->leaf);
+	write_value(f, v->sapling);
+	write_value(f, v->expansion_depth);
+	write_value(f, v->regrow_level);
+	write_string(f, v->heur_strategy != nullptr ? v->heur_strategy->print(&(v->bc)) : "");
+    }
+
+    write_value(f, (uint64_t) d->alg_by_id.size());
+    for (const auto& [id, v] : d->alg_by_id)
+    {
+	write_value(f, id);
+	write_binconf(f, v->bc);
+	write_value(f, v->next_item);
+	write_value(f, v->state);
+	write_value(f, v->win);
+	write_value(f, v->leaf);
+	write_string(f, v->optimal);
+    }
+
+    // New edges are inserted at the front of the lists, so we store them in reverse,
+    // which keeps the order of the children (and thus of the saplings) when loading.
+    uint64_t adv_edge_count = 0, alg_edge_count = 0;
+    for (const auto& [id, v] : d->adv_by_id)
+    {
+	adv_edge_count += v->out.size();
+    }
+    for (const auto& [id, v] : d->alg_by_id)
+    {
+	alg_edge_count += v->out.size();
+    }
+
+    write_value(f, adv_edge_count);
+    for (const auto& [id, v] : d->adv_by_id)
+    {
+	for (auto it = v->out.rbegin(); it != v->out.rend(); it++)
+	{
+	    write_value(f, id);
+	    write_value(f, (*it)->to->id);
+	    write_value(f, (*it)->item);
+	}
+    }
+
+    write_value(f, alg_edge_count);
+    for (const auto& [id, v] : d->alg_by_id)
+    {
+	for (auto it = v->out.rbegin(); it != v->out.rend(); it++)
+	{
+	    write_value(f, id);
+	    write_value(f, (*it)->to->id);
+	    write_value(f, (*it)->target_bin);
+	}
+    }
+
+    close_and_replace(f, dag_file_path);
+
+    // The solutions of the previous round are of no use anymore.
+    std::filesystem::remove(tasks_file_path);
+    last_save = std::chrono::steady_clock::now();
+    print_if<VERBOSE>("Queen: Checkpoint of round %d saved, %zu + %zu vertices.\n",
+		      counters.round, d->adv_by_id.size(), d->alg_by_id.size());
+}
+
+// Returns nullptr if the checkpoint cannot be read.
+dag* checkpoint::load_dag(queen_counters& counters)
+{
+    FILE *f = fopen(dag_file_path, "rb");
+    assert(f != nullptr);
+
+    dag *d = new dag;
+    std::unordered_map<uint64_t, adversary_vertex*> adv_by_old_id;
+    std::unordered_map<uint64_t, algorithm_vertex*> alg_by_old_id;
+    uint64_t root_id = 0, count = 0;
+
+    bool ret = check_signature(f, counters.round)
+	&& read_value(f, counters.winning_saplings)
+	&& read_value(f, counters.evaluation)
+	&& read_value(f, counters.expansion)
+	&& read_value(f, root_id)
+	&& read_value(f, count);
+
+    for (uint64_t i = 0; ret && i < count; i++)
+    {
+	uint64_t id = 0;
+	binconf b;
+	vert_state state = vert_state::fresh;
+	victory win = victory::uncertain;
+	leaf_type leaf = leaf_type::nonleaf;
+	bool sapling = false;
+	int expansion_depth = 0, regrow_level = 0;
+	std::string heurstring;
+	ret = read_value(f, id) && read_binconf(f, b) && read_value(f, state) && read_value(f, win)
+	    && read_value(f, leaf) && read_value(f, sapling) && read_value(f, expansion_depth)
+	    && read_value(f, regrow_level) && read_string(f, heurstring);
+	if (ret)
+	{
+	    adversary_vertex *v = d->add_adv_vertex(b, heurstring);
+	    v->state = state;
+	    v->win = win;
+	    v->leaf = leaf;
+	    v->sapling = sapling;
+	    v->expansion_depth = expansion_depth;
+	    v->regrow_level = regrow_level;
+	    adv_by_old_id[id] = v;
+	}
+    }
+
+    ret = ret && read_value(f, count);
+    for (uint64_t i = 0; ret && i < count; i++)
+    {
+	uint64_t id = 0;
+	binconf b;
+	int next_item = 0;
+	vert_state state = vert_state::fresh;
+	victory win = victory::uncertain;
+	leaf_type leaf = leaf_type::nonleaf;
+	std::string optimal;
+	ret = read_value(f, id) && read_binconf(f, b) && read_value(f, next_item) && read_value(f, state)
+	    && read_value(f, win) && read_value(f, leaf) && read_string(f, optimal);
+	if (ret)
+	{
+	    algorithm_vertex *v = d->add_alg_vertex(b, next_item, optimal);
+	    v->state = state;
+	    v->win = win;
+	    v->leaf = leaf;
+	    alg_by_old_id[id] = v;
+	}
+    }
+
+    ret = ret && read_value(f, count);
+    for (uint64_t i = 0; ret && i < count; i++)
+    {
+	uint64_t from = 0, to = 0;
+	int item = 0;
+	ret = read_value(f, from) && read_value(f, to) && read_value(f, item)
+	    && adv_by_old_id.contains(from) && alg_by_old_id.contains(to);
+	if (ret)
+	{
+	    d->add_adv_outedge(adv_by_old_id[from], alg_by_old_id[to], item);
+	}
+    }
+
+    ret = ret && read_value(f, count);
+    for (uint64_t i = 0; ret && i < count; i++)
+    {
+	uint64_t from = 0, to = 0;
+	int target_bin = 0;
+	ret = read_value(f, from) && read_value(f, to) && read_value(f, target_bin)
+	    && alg_by_old_id.contains(from) && adv_by_old_id.contains(to);
+	if (ret)
+	{
+	    d->add_alg_outedge(alg_by_old_id[from], adv_by_old_id[to], target_bin);
+	}
+    }
+
+    fclose(f);
+
+    if (!ret || !adv_by_old_id.contains(root_id))
+    {
+	fprintf(stderr, "Reading the checkpoint %s: signature or data verification failed.\n", dag_file_path);
+	d->free_vertices();
+	delete d;
+	return nullptr;
+    }
+
+    d->root = adv_by_old_id[root_id];
+    print_if<PROGRESS>("Queen: Resuming round %d from the checkpoint, %zu + %zu vertices.\n",
+		       counters.round, d->adv_by_id.size(), d->alg_by_id.size());
+    return d;
+}
+
+// Stores the solved tasks of the current round (the task arrays must be present).
+void checkpoint::save_solutions(int round)
+{
+    FILE *f = open_for_writing(tasks_file_path);
+    write_signature(f, round);
+
+    uint64_t solved = 0;
+    for (int i = 0; i < tcount; i++)
+    {
+	task_status status = tstatus[i].load(std::memory_order_acquire);
+	if (status == task_status::adv_win || status == task_status::alg_win)
+	{
+	    solved++;
+	}
+    }
+
+    write_value(f, solved);
+    for (int i = 0; i < tcount; i++)
+    {
+	task_status status = tstatus[i].load(std::memory_order_acquire);
+	if (status == task_status::adv_win || status == task_status::alg_win)
+	{
+	    write_binconf(f, tarray[i].bc);
+	    write_value(f, status);
+	}
+    }
+
+    close_and_replace(f, tasks_file_path);
+    last_save = std::chrono::steady_clock::now();
+    print_if<VERBOSE>("Queen: Checkpoint of %" PRIu64 " solved tasks saved.\n", solved);
+}
+
+void checkpoint::load_solutions()
+{
+    resumed_solutions.clear();
+    resumed_round = -1;
+    if (!std::filesystem::exists(tasks_file_path))
+    {
+	return;
+    }
+
+    FILE *f = fopen(tasks_file_path, "rb");
+    assert(f != nullptr);
+    uint64_t count = 0;
+    bool ret = check_signature(f, resumed_round) && read_value(f, count);
+    for (uint64_t i = 0; ret && i < count; i++)
+    {
+	binconf b;
+	task_status status = task_status::available;
+	ret = read_binconf(f, b) && read_value(f, status);
+	if (ret)
+	{
+	    resumed_solutions[b.hash_with_last()] = status;
+	}
+    }
+    fclose(f);
+
+    if (!ret)
+    {
+	fprintf(stderr, "Reading the checkpoint %s: signature or data verification failed.\n", tasks_file_path);
+	resumed_solutions.clear();
+	resumed_round = -1;
+    }
+}
+
+// Marks the tasks solved before the resumption, if the round is the resumed one.
+// Returns the number of tasks marked.
+int checkpoint::apply_solutions(int round)
+{
+    if (round != resumed_round || resumed_solutions.empty())
+    {
+	return 0;
+    }
+
+    std::vector<int> solution_pairs;
+    for (int i = 0; i < tcount; i++)
+    {
+	auto it = resumed_solutions.find(tarray[i].bc.hash_with_last());
+	if (it != resumed_solutions.end())
+	{
+	    solution_pairs.push_back(i);
+	    solution_pairs.push_back(static_cast<int>(it->second));
+	}
+    }
+
+    apply_solution_pairs(solution_pairs.data(), solution_pairs.size());
+    resumed_solutions.clear();
+    print_if<PROGRESS>("Queen: %zu tasks were solved before the resumption.\n", solution_pairs.size() / 2);
+    return solution_pairs.size() / 2;
+}
+
+// A finished computation leaves no checkpoint behind.
+void checkpoint::remove()
+{
+    std::filesystem::remove(dag_file_path);
+    std::filesystem::remove(tasks_file_path);
+}
+
+#endif // _CHECKPOINT_HPP
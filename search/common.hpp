@@ -46,10 +46,16 @@ const int TASK_DEPTH_STEP = 0; // The amount by which the depth is increased whe
 // whether to print the output as a single tree or as multiple trees.
 const bool SINGLE_TREE = true;
 
-// log tasks which run at least some amount of time
+// print tasks which run at least some amount of time
 const bool TASKLOG = false;
 const long double TASKLOG_THRESHOLD = 60.0; // in seconds
 
+// Order the tasks of a round by a cost model (see task_cost.hpp). The overseers report the
+// processing times of solved tasks to the queen, which trains the model after each round and
+// keeps the samples in its task log for later runs. Without enough samples, the queen falls
+// back to reversing the queue.
+const bool TASK_COST_ORDERING = true;
+
 #define STRATEGY STRATEGY_BASIC // choices: STRATEGY_BASIC, STRATEGY_NINETEEN_FREQ, STRATEGY_BOUNDED
 
 #define DYNPROG_MAX dynprog_max_direct // choices: dynprog_max_direct, dynprog_max_with_lih
@@ -90,6 +96,17 @@ uint64_t dpht_size = 0;
 int task_depth = TASK_DEPTH_INIT;
 int task_load = TASK_LOAD_INIT;
 
+// The bounds of one generation, passed to POSSIBLE_TASK. Each generation carries
+// its own copy, so that two saplings can be generated with different bounds at once.
+struct task_bounds
+{
+    int depth = TASK_DEPTH_INIT;
+    int load = TASK_LOAD_INIT;
+    int root_load = 0; // The total load of the sapling being generated.
+
+    bool operator==(const task_bounds& other) const = default;
+};
+
 const unsigned int LOADLOG = 12;
 
 // Printing constants.
@@ -104,6 +121,10 @@ const bool FIVE_NINE_ACTIVE = true;
 const bool FIVE_NINE_ACTIVE_EVERYWHERE = true;
 
 const bool USING_HEURISTIC_VISITS = true;
+// Extends the heuristic visit by one more ply: an uncertain move of the algorithm is
+// discarded if the adversary has a feasible reply whose every placement is a cached adversary win.
+constexpr bool USING_TWO_PLY_VISITS = true && USING_HEURISTIC_VISITS;
+constexpr int TWO_PLY_ITEM_LIMIT = 4; // How many of the largest feasible items are tried in the second ply.
 constexpr bool USING_HEURISTIC_KNOWNSUM = false; // Recommend turning off when WEIGHTSUM is true.
 constexpr bool USING_HEURISTIC_GS = false;
 constexpr bool USING_KNOWNSUM_LOWSEND = false;
@@ -113,13 +134,82 @@ constexpr bool USING_HEURISTIC_WEIGHTSUM = false && (!USING_HEURISTIC_KNOWNSUM)
 
 #define WEIGHT_HEURISTICS weight_heuristics<scale_halves, scale_thirds>
 
+// A dominance index for adversary positions which differ only in the lowest sendable item.
+// It takes 2^(conflog - DOMINANCE_CACHE_SHRINK) bytes next to the adversarial state cache.
+// With full generality (monotonicity S-1) the lowest sendable item is always 1, and the index is not needed.
+constexpr bool USING_DOMINANCE_CACHE = true && (monotonicity < S-1);
+constexpr int DOMINANCE_CACHE_SHRINK = 3;
+
+// An endgame tablebase of all positions with remaining volume (S*BINS minus the total load)
+// at most TABLEBASE_VOLUME. It is built offline by minitools/tablebase.cpp; if no table
+// is found in ./cache/, the search runs without it.
+constexpr bool USING_TABLEBASE = true;
+constexpr int TABLEBASE_VOLUME = S;
+
+// Workers explore tasks by depth-first proof-number search instead of minimax.
+// Selected at build time by ./compile.sh --dfpn, so that both engines can be run on the same tasks.
+#ifdef DFPN
+constexpr bool USING_DFPN = true;
+#else
+constexpr bool USING_DFPN = false;
+#endif
+
+// The queen and a single overseer run as threads of one process, sharing the task array,
+// the task statuses and the caches instead of communicating over MPI.
+// Selected at build time by ./compile.sh --local.
+#ifdef LOCAL
+constexpr bool LOCAL_COMMUNICATOR = true;
+#else
+constexpr bool LOCAL_COMMUNICATOR = false;
+#endif
+
 constexpr bool USING_MINIBINSTRETCHING = true;
 constexpr int MINIBS_SCALE_QUEEN = 12; // Minibinstretching scale for the DAG generation phase.
 constexpr int MINIBS_SCALE_WORKER = 12; // Minibinstretching scale for the exploration phase.
 
 // batching constants
+// The batch size adapts to the throughput of each overseer: an overseer asks for roughly
+// BATCH_TARGET_SECONDS worth of tasks, within the bounds below. BATCH_SIZE is the size
+// of the first batch of a round, before any throughput is measured.
 const int BATCH_SIZE = 50;
 const int BATCH_THRESHOLD = BATCH_SIZE / 2;
+const int MIN_BATCH_SIZE = 8;
+const int MAX_BATCH_SIZE = 2048;
+const double BATCH_TARGET_SECONDS = 0.5;
+
+// Broadcast the task array as one compressed buffer (in chunks of BROADCAST_CHUNK_BYTES)
+// instead of one broadcast per task.
+const bool BULK_TASK_BROADCAST = true;
+const int BROADCAST_CHUNK_BYTES = 1 << 26;
+
+// Overseers report solutions to the queen in messages of up to SOLUTION_BATCH_SIZE
+// (task id, status) pairs, sent when full or when the oldest pending solution is
+// SOLUTION_FLUSH_MS milliseconds old. Pruned task ids travel the other way in messages of
+// up to PRUNED_BATCH_SIZE ids.
+const int SOLUTION_BATCH_SIZE = 256;
+const int SOLUTION_FLUSH_MS = 10;
+const int PRUNED_BATCH_SIZE = 4096;
+
+// The queen sends newly pruned tasks to the overseers, so that the workers abort them
+// (check_messages() sees the pruned status) instead of finishing a useless computation.
+const bool PRUNED_PROPAGATION = true;
+
+// Once the queen runs out of tasks, an idle overseer asks the other overseers
+// for their unstarted tasks instead of waiting for the end of the round.
+const bool USING_WORK_STEALING = true;
+
+// An alternative transport of task statuses: the queen hosts an MPI window into which the
+// overseers write their solutions and from which they read pruned tasks, using one-sided
+// communication (net/mpi/rma.hpp). The batching of solutions above still applies.
+const bool USING_RMA_TSTATUS = false;
+
+// For very large clusters: if positive, every group of SUBQUEEN_FANOUT overseers is served
+// by a sub-queen process, which hands out tasks from its own slice of the task queue and
+// aggregates the solutions of its group before passing them to the queen.
+// A value of 0 connects all overseers to the queen directly.
+const int SUBQUEEN_FANOUT = 0;
+static_assert(SUBQUEEN_FANOUT == 0 || !USING_RMA_TSTATUS,
+	      "The status window is shared with the queen only; it cannot be used with sub-queens.");
 
 // sizes of the hash tables
 const llu LOADSIZE = (1ULL<<LOADLOG);
@@ -135,10 +225,49 @@ const int BESTFIT_THRESHOLD = (1*S)/10;
 
 const int EXPANSION_DEPTH = 3;
 const int TASK_LARGEST_ITEM = 5;
-// how much the updater thread sleeps (in milliseconds)
+// The longest sleep (in milliseconds) of a thread waiting for an event. Threads are woken up
+// earlier by wakeup_event (see wakeup.hpp); the tick bounds the latency of polling MPI messages.
 const int TICK_SLEEP = 20;
 
 const int TICK_UPDATE = 100;
+// The updater propagates each finished task only to the affected ancestors in the sapling,
+// instead of re-evaluating the whole sapling. Every FULL_UPDATE_PERIOD-th update is still
+// a full one, as is the update which confirms that no tasks remain.
+const bool INCREMENTAL_UPDATER = true;
+const int FULL_UPDATE_PERIOD = 100;
+// While the tasks of one sapling are being solved, the queen generates the next sapling
+// into a separate DAG (see pipelining.hpp). If that sapling is the next job once the round
+// ends, its DAG is grafted into the main one and the generation phase is skipped.
+const bool SAPLING_PIPELINING = true;
+// The queen evaluates up to this many uncertain saplings in one round, with their tasks
+// in one task array, so that small saplings do not leave the overseers idle. The round
+// ends once all of them are decided. Expansion saplings are always evaluated alone.
+const int SAPLINGS_PER_ROUND = 8;
+// The queen generates the subtrees below GENERATION_SPLIT_DEPTH (counted in calls,
+// two per item) in GENERATION_THREADS threads (see parallel_generation.hpp).
+const bool PARALLEL_GENERATION = true;
+const int GENERATION_THREADS = 4;
+const int GENERATION_SPLIT_DEPTH = 4;
+// The queen stores the DAG at the start of each round and the solved tasks every
+// CHECKPOINT_PERIOD seconds (see checkpoint.hpp), so that the run can be resumed.
+const bool CHECKPOINTING = true;
+const int CHECKPOINT_PERIOD = 300;
+// The queen chooses the task bounds of each sapling by random probes of its game tree
+// (see autotuning.hpp), aiming at AUTOTUNE_TARGET_TASKS tasks per sapling, each taking
+// about AUTOTUNE_TASK_SECONDS if the task cost model is trained.
+const bool AUTOTUNING = false;
+const int AUTOTUNE_PROBES = 1000;
+const int AUTOTUNE_TARGET_TASKS = 5000;
+const double AUTOTUNE_TASK_SECONDS = 10.0;
+const uint64_t AUTOTUNE_SEED = 12345;
+// With --estimate, the queen only samples the tasks of each sapling for ESTIMATE_SECONDS
+// and extrapolates the running time (see estimation.hpp).
+const int ESTIMATE_SECONDS = 60;
+const uint64_t ESTIMATE_SEED = 12345;
+// The queen remembers the results of solved tasks and does not send out the same task
+// in a later round again; optionally the results are kept in ./cache between runs.
+const bool TASK_STORE = true;
+const bool TASK_STORE_ON_DISK = false;
 // how many tasks are sufficient for the updater to run the main updater routine
 const int TICK_TASKS = 50;
 // the number of completed tasks after which the exploring thread reports progress
@@ -267,6 +396,9 @@ char ADVICE_FILENAME[256];
 char ROOT_FILENAME[256];
 bool CUSTOM_ROOTFILE = false;
 bool USING_ADVISOR = false;
+bool RESUMING = false; // Resume from the last checkpoint, if there is one.
+bool ESTIMATING = false; // Estimate the running time instead of computing.
+int ESTIMATE_WORKERS = 0; // The number of workers the running time is estimated for.
 
 
 uint64_t global_vertex_counter = 0;
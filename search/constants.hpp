@@ -89,6 +89,9 @@ const int PERMANENT = 1;
 // bitsize of queen's dpcache
 const unsigned int QUEEN_DPLOG = 26;
 
+// bitsize of the queen's caches for sampling tasks with --estimate
+const unsigned int QUEEN_ESTIMATE_CONFLOG = 28;
+
 // worker's get_task() constants
 const int NO_MORE_TASKS = -1;
 const int WAIT_FOR_TASK = 0;
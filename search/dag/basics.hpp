@@ -212,7 +212,7 @@ void dag::clear_visited_secondary()
  */
 
 /* Forward declaration of remove_task for inclusion purposes. */
-void remove_task(uint64_t hash);
+void remove_task(const adversary_vertex *v);
 
 template <minimax MODE> void dag::remove_inedge(adv_outedge *e)
 {
@@ -241,7 +241,7 @@ template <minimax MODE> void dag::remove_inedge(alg_outedge *e)
 	// when updating the tree, if e->to is task, remove it from the queue
 	if (MODE == minimax::updating && e->to->task && e->to->win == victory::uncertain)
 	{
-	    remove_task(e->to->bc.hash_with_last());
+	    remove_task(e->to);
 	}
 	
 	del_adv_vertex(e->to);
@@ -104,6 +104,10 @@ public:
     // Cloning subroutines.
     dag* subdag(adversary_vertex *newroot);
     dag* subtree(adversary_vertex *newroot);
+
+    // Grafting subroutines.
+    bool graft(dag *side, adversary_vertex *target, bool accept_visited);
+    void free_vertices();
     
 private:
     void clone_subdag(dag *processing,
@@ -181,6 +185,7 @@ public:
 
     int expansion_depth = 0;
     bool task = false; // Task is a separate boolean because a boundary vertex may or may not be a task.
+    int task_id = -1; // The index into the task array of the round in which the vertex became a task.
     bool sapling = false;
 
     leaf_type leaf = leaf_type::nonleaf;
@@ -6,6 +6,7 @@
 #include "class.hpp" // Base class.
 #include "basics.hpp" // Basic methods.
 #include "cloning.hpp" // Cloning methods.
+#include "grafting.hpp" // Grafting methods.
 #include "print.hpp" // Printing.
 
 #endif
@@ -0,0 +1,171 @@
+#ifndef _DAG_GRAFTING_HPP
+#define _DAG_GRAFTING_HPP 1
+
+// Moving a DAG generated elsewhere into the current one. The side DAG is generated
+// from a copy of one vertex of the current DAG (its root), without any knowledge of
+// the current DAG; grafting attaches its contents below the original vertex.
+
+// The side DAG may contain positions which are also present in the current DAG. Such a vertex
+// is taken from the current DAG, which is only allowed if the adversary wins it there or,
+// when accept_visited is set, if it has been visited by the ongoing generation.
+// Returns false and leaves both DAGs untouched if some shared position is not allowed.
+// On success, the side DAG is deleted.
+
+bool dag::graft(dag *side, adversary_vertex *target, bool accept_visited)
+{
+    adversary_vertex *root_copy = side->root;
+    assert(target->out.empty());
+
+    std::vector<std::pair<adversary_vertex*, adversary_vertex*>> adv_replaced;
+    std::vector<std::pair<algorithm_vertex*, algorithm_vertex*>> alg_replaced;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-variable"
+    for (auto& [hash, vert] : side->adv_by_hash)
+    {
+	auto it = adv_by_hash.find(hash);
+	if (vert == root_copy || it == adv_by_hash.end())
+	{
+	    continue;
+	}
+	if (it->second->win != victory::adv && !(accept_visited && it->second->visited))
+	{
+	    return false;
+	}
+	adv_replaced.emplace_back(vert, it->second);
+    }
+
+    for (auto& [hash, vert] : side->alg_by_hash)
+    {
+	auto it = alg_by_hash.find(hash);
+	if (it == alg_by_hash.end())
+	{
+	    continue;
+	}
+	if (it->second->win != victory::adv && !(accept_visited && it->second->visited))
+	{
+	    return false;
+	}
+	alg_replaced.emplace_back(vert, it->second);
+    }
+
+    // First, all edges into the copies are redirected, so that the copies are unreachable.
+    // Only then the copies are deleted along with whatever is reachable only through them.
+    for (auto& [copy, original] : adv_replaced)
+    {
+	for (alg_outedge *e : copy->in)
+	{
+	    e->to = original;
+	}
+	original->in.splice(original->in.end(), copy->in);
+    }
+
+    for (auto& [copy, original] : alg_replaced)
+    {
+	for (adv_outedge *e : copy->in)
+	{
+	    e->to = original;
+	}
+	original->in.splice(original->in.end(), copy->in);
+    }
+
+    for (auto& [copy, original] : adv_replaced)
+    {
+	side->remove_outedges<minimax::generating>(copy);
+	side->del_adv_vertex(copy);
+    }
+
+    for (auto& [copy, original] : alg_replaced)
+    {
+	side->remove_outedges<minimax::generating>(copy);
+	side->del_alg_vertex(copy);
+    }
+
+    // The remaining vertices and edges receive new internal IDs.
+    for (auto& [hash, vert] : side->adv_by_hash)
+    {
+	if (vert == root_copy)
+	{
+	    continue;
+	}
+
+	vert->id = vertex_counter++;
+	adv_by_hash[hash] = vert;
+	adv_by_id[vert->id] = vert;
+	for (adv_outedge *e : vert->out)
+	{
+	    e->id = edge_counter++;
+	}
+    }
+
+    for (auto& [hash, vert] : side->alg_by_hash)
+    {
+	vert->id = vertex_counter++;
+	alg_by_hash[hash] = vert;
+	alg_by_id[vert->id] = vert;
+	for (alg_outedge *e : vert->out)
+	{
+	    e->id = edge_counter++;
+	}
+    }
+#pragma GCC diagnostic pop
+
+    // Splicing keeps the positions stored in the edges valid.
+    for (adv_outedge *e : root_copy->out)
+    {
+	e->from = target;
+	e->id = edge_counter++;
+    }
+    target->out.splice(target->out.end(), root_copy->out);
+
+    target->win = root_copy->win;
+    target->leaf = root_copy->leaf;
+    target->heur_vertex = root_copy->heur_vertex;
+    std::swap(target->heur_strategy, root_copy->heur_strategy);
+
+    print_if<DEBUG>("Grafted %zu new vertices, %zu positions were already present.\n",
+		      side->adv_by_hash.size() - 1 + side->alg_by_hash.size(),
+		      adv_replaced.size() + alg_replaced.size());
+
+    // All vertices but the root copy belong to this DAG now.
+    side->adv_by_hash.clear();
+    side->adv_by_id.clear();
+    side->alg_by_hash.clear();
+    side->alg_by_id.clear();
+    delete root_copy;
+    delete side;
+    return true;
+}
+
+// Deletes all vertices and edges, so that the DAG itself can be deleted.
+void dag::free_vertices()
+{
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-variable"
+    for (auto& [hash, vert] : adv_by_hash)
+    {
+	for (adv_outedge *e : vert->out)
+	{
+	    del_adv_outedge(e);
+	}
+	delete vert;
+    }
+
+    for (auto& [hash, vert] : alg_by_hash)
+    {
+	for (alg_outedge *e : vert->out)
+	{
+	    del_alg_outedge(e);
+	}
+	delete vert;
+    }
+#pragma GCC diagnostic pop
+
+    adv_by_hash.clear();
+    adv_by_id.clear();
+    alg_by_hash.clear();
+    alg_by_id.clear();
+    root = nullptr;
+}
+
+#endif // _DAG_GRAFTING_HPP
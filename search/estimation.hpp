@@ -0,0 +1,266 @@
+#ifndef _ESTIMATION_HPP
+#define _ESTIMATION_HPP 1
+
+// Estimates of the running time of a computation.
+
+// With --estimate, the queen only generates the saplings, one per round, and instead of
+// the parallel phase, it solves a random sample of the tasks of each sapling itself, for
+// ESTIMATE_SECONDS. The mean time of a sampled task times the number of tasks estimates
+// the CPU time of the sapling. The updater would prune some of the tasks, so the estimate
+// is rather pessimistic; on the other hand, it covers only the saplings known at the start,
+// not the later expansions.
+
+// During a regular round, the queen reports the expected end of the round from the rate
+// at which the solved tasks arrive.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "binconf.hpp"
+#include "saplings.hpp"
+#include "tasks.hpp"
+#include "exceptions.hpp"
+#include "minibs.hpp"
+#include "minimax/computation.hpp"
+#include "minimax/recursion.hpp"
+#include "minimax/dfpn.hpp"
+
+// Prints a duration in seconds as hours, minutes and seconds.
+std::string format_duration(double seconds)
+{
+    char buf[64];
+    uint64_t total = (uint64_t) std::max(0.0, seconds);
+    sprintf(buf, "%" PRIu64 ":%02" PRIu64 ":%02" PRIu64, total / 3600, (total / 60) % 60, total % 60);
+    return std::string(buf);
+}
+
+class work_estimator
+{
+public:
+    struct sapling_estimate
+    {
+	binconf root;
+	int tasks = 0;
+	std::vector<double> sampled; // Running times of the sampled tasks, in seconds.
+	int cut_off = 0; // Sampled tasks stopped by the time limit; their times are lower bounds.
+
+	double mean() const
+	    {
+		if (sampled.empty())
+		{
+		    return 0.0;
+		}
+		return std::accumulate(sampled.begin(), sampled.end(), 0.0) / sampled.size();
+	    }
+
+	double cpu_seconds() const
+	    {
+		return mean() * tasks;
+	    }
+    };
+
+    std::vector<sapling_estimate> saplings;
+    minibs<MINIBS_SCALE_WORKER> *mbs = nullptr;
+
+    ~work_estimator()
+	{
+	    delete mbs;
+	}
+
+    void sample(const sapling &job, WEIGHT_HEURISTICS *weight_heurs);
+    void print_summary(FILE *stream, int workers);
+
+private:
+    void allocate_caches();
+};
+
+// The overseers allocate the caches of the workers; in the local mode, they are shared
+// with the queen, otherwise the queen needs smaller ones of its own.
+void work_estimator::allocate_caches()
+{
+    if (adv_cache == nullptr)
+    {
+	adv_cache = new state_cache(QUEEN_ESTIMATE_CONFLOG, 1, "adversarial");
+    }
+
+    if (USING_DOMINANCE_CACHE && dom_cache == nullptr)
+    {
+	dom_cache = new dominance_cache(QUEEN_ESTIMATE_CONFLOG - DOMINANCE_CACHE_SHRINK);
+    }
+
+    if (USING_MINIBINSTRETCHING && mbs == nullptr)
+    {
+	mbs = new minibs<MINIBS_SCALE_WORKER>();
+	mbs->init();
+    }
+}
+
+// Solves the tasks in tarray in a random order until ESTIMATE_SECONDS pass.
+void work_estimator::sample(const sapling &job, WEIGHT_HEURISTICS *weight_heurs)
+{
+    allocate_caches();
+
+    sapling_estimate estimate;
+    estimate.root = job.root->bc;
+    estimate.tasks = tcount;
+
+    std::vector<int> order(tcount);
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937_64 rng(ESTIMATE_SEED ^ job.root->bc.hash_with_last());
+    std::shuffle(order.begin(), order.end(), rng);
+
+    computation<minimax::exploring, MINIBS_SCALE_WORKER> comp;
+    worker_flags flags;
+    if (USING_HEURISTIC_WEIGHTSUM)
+    {
+	comp.weight_heurs = weight_heurs;
+    }
+
+    if (USING_MINIBINSTRETCHING)
+    {
+	comp.mbs = mbs;
+    }
+
+    // A task running past the deadline is stopped the same way as when the round ends.
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(ESTIMATE_SECONDS);
+    std::mutex timer_mutex;
+    std::condition_variable timer_cv;
+    bool sampling_over = false;
+    std::thread timer([&]() {
+	std::unique_lock<std::mutex> lk(timer_mutex);
+	if (!timer_cv.wait_until(lk, deadline, [&]() { return sampling_over; }))
+	{
+	    flags.root_solved = true;
+	}
+    });
+
+    for (int task_id : order)
+    {
+	if (std::chrono::steady_clock::now() >= deadline)
+	{
+	    break;
+	}
+
+	comp.reset(task_id);
+	comp.flags = &flags;
+	binconf task_copy;
+	duplicate(&task_copy, &(tarray[task_id].bc));
+
+	auto task_start = std::chrono::steady_clock::now();
+	bool finished = true;
+	try
+	{
+	    if (USING_DFPN)
+	    {
+		explore_dfpn(&task_copy, &comp);
+	    } else
+	    {
+		explore(&task_copy, &comp);
+	    }
+	} catch (computation_irrelevant &e)
+	{
+	    finished = false;
+	}
+
+	std::chrono::duration<double> task_time = std::chrono::steady_clock::now() - task_start;
+	estimate.sampled.push_back(task_time.count());
+	if (!finished)
+	{
+	    estimate.cut_off++;
+	    break;
+	}
+    }
+
+    {
+	std::unique_lock<std::mutex> lk(timer_mutex);
+	sampling_over = true;
+    }
+    timer_cv.notify_one();
+    timer.join();
+
+    print_if<PROGRESS>("Estimate: sampled %zu of %d tasks, %.3lf s per task on average, %.2lf CPU hours for the sapling.\n",
+		       estimate.sampled.size(), estimate.tasks, estimate.mean(), estimate.cpu_seconds() / 3600.0);
+    saplings.push_back(estimate);
+}
+
+// The saplings are evaluated one after another, so the wall time of each is at least
+// the time of its longest task.
+void work_estimator::print_summary(FILE *stream, int workers)
+{
+    double total_cpu = 0.0;
+    double total_wall = 0.0;
+    bool lower_bound = false;
+
+    fprintf(stream, "Estimate of %d/%d Bin Stretching on %d bins with monotonicity %d:\n", R, S, BINS, monotonicity);
+    for (unsigned int i = 0; i < saplings.size(); i++)
+    {
+	const sapling_estimate &e = saplings[i];
+	std::vector<double> sorted = e.sampled;
+	std::sort(sorted.begin(), sorted.end());
+
+	fprintf(stream, "Sapling %u ", i);
+	print_binconf_stream(stream, e.root, false);
+	if (sorted.empty())
+	{
+	    fprintf(stream, ": %d tasks, none sampled.\n", e.tasks);
+	    continue;
+	}
+
+	fprintf(stream, ": %d tasks, %zu sampled (%d cut off), task time min %.3lf s, median %.3lf s, "
+		"90th percentile %.3lf s, max %.3lf s; %.2lf CPU hours.\n",
+		e.tasks, sorted.size(), e.cut_off, sorted.front(), sorted[sorted.size() / 2],
+		sorted[(sorted.size() * 9) / 10], sorted.back(), e.cpu_seconds() / 3600.0);
+
+	total_cpu += e.cpu_seconds();
+	total_wall += std::max(e.cpu_seconds() / workers, sorted.back());
+	lower_bound = lower_bound || (e.cut_off > 0);
+    }
+
+    fprintf(stream, "Estimated total: %s%.2lf CPU hours, %s wall time with %d workers.\n",
+	    lower_bound ? "at least " : "", total_cpu / 3600.0, format_duration(total_wall).c_str(), workers);
+}
+
+// The expected end of the round, from the rate at which the tasks were collected recently.
+class round_eta
+{
+public:
+    static constexpr int WINDOW = 20; // The number of reports the rate is computed from.
+    std::deque<std::pair<std::chrono::steady_clock::time_point, unsigned int>> reports;
+
+    void start()
+	{
+	    reports.clear();
+	    reports.emplace_back(std::chrono::steady_clock::now(), 0);
+	}
+
+    // Returns the number of seconds until the remaining tasks are collected, or a negative
+    // number if no rate is known yet.
+    double seconds_left(unsigned int collected, uint64_t remaining)
+	{
+	    reports.emplace_back(std::chrono::steady_clock::now(), collected);
+	    if ((int) reports.size() > WINDOW)
+	    {
+		reports.pop_front();
+	    }
+
+	    std::chrono::duration<double> span = reports.back().first - reports.front().first;
+	    unsigned int solved = reports.back().second - reports.front().second;
+	    if (solved == 0 || span.count() <= 0.0)
+	    {
+		return -1.0;
+	    }
+
+	    return remaining * span.count() / solved;
+	}
+};
+
+#endif // _ESTIMATION_HPP
@@ -3,7 +3,11 @@
 #include <csignal>
 #include <inttypes.h>
 
+#ifdef LOCAL
+#include "net/local.hpp"
+#else
 #include "net/mpi.hpp"
+#endif
 
 #include "common.hpp"
 #include "functions.hpp"
@@ -16,6 +20,7 @@
 #include "queen.hpp"
 #include "worker_methods.hpp"
 #include "overseer_methods.hpp"
+#include "subqueen.hpp"
 #include "queen_methods.hpp"
 
 // We employ a bit of indirection to account for both concurrent
@@ -81,8 +86,37 @@ std::pair<bool,std::string> parse_parameter_rootfile(int argc, char **argv, int
     return std::make_pair(false, "");
 }
 
+bool parse_parameter_resume(int argc, char **argv, int pos)
+{
+    return strcmp(argv[pos], "--resume") == 0;
+}
+
+std::pair<bool,int> parse_parameter_estimate(int argc, char **argv, int pos)
+{
+    int workers = 0;
+
+    if (strcmp(argv[pos], "--estimate") == 0)
+    {
+	if (pos == argc-1 || sscanf(argv[pos+1], "%d", &workers) != 1 || workers <= 0)
+	{
+	    fprintf(stderr, "Error: parameter --estimate must be followed by a positive number of workers.\n");
+	    exit(-1);
+	}
+
+	return std::make_pair(true, workers);
+    }
+    return std::make_pair(false, 0);
+}
+
 void overseer_main_thread(int argc, char** argv)
 {
+    if (multiprocess::is_subqueen(multiprocess::world_rank))
+    {
+	subqueen sq;
+	sq.start();
+	return;
+    }
+
 	    ov = new overseer();
 	    ov->start();
 }
@@ -102,6 +136,23 @@ void queen_main_thread(int argc, char** argv)
     // binary_print(stderr, somenumber);
     // fprintf(stderr, "\n");
 
+    for (int i = 1; i < argc; i++)
+    {
+	if (parse_parameter_resume(argc, argv, i))
+	{
+	    RESUMING = true;
+	    print_if<VERBOSE>("Found the --resume flag.\n");
+	}
+
+	auto [estimate_flag, workers] = parse_parameter_estimate(argc, argv, i);
+	if (estimate_flag)
+	{
+	    ESTIMATING = true;
+	    ESTIMATE_WORKERS = workers;
+	    print_if<VERBOSE>("Found the --estimate flag, value %d.\n", workers);
+	}
+    }
+
     for (int i = 0; i <= argc-2; i++)
     {
 	auto [advfile_flag, advice_file] = parse_parameter_advfile(argc, argv, i);
@@ -148,7 +199,10 @@ void queen_main_thread(int argc, char** argv)
 
     // After the computation is over, if this thread is the queen, print the output.
     assert(ret == 0 || ret == 1);
-    if(ret == 0)
+    if (ret == 0 && ESTIMATING)
+    {
+	// The queen has printed the estimate.
+    } else if(ret == 0)
     {
 	fprintf(stdout, "Lower bound for %d/%d Bin Stretching on %d bins with monotonicity %d from ",
 		R,S,BINS,monotonicity);
@@ -65,6 +65,11 @@ struct measure_attr
     uint64_t adv_vertices_visited = 0;
     uint64_t alg_vertices_visited = 0;
 
+    // Proof-number search.
+    uint64_t dfpn_adv_visits = 0;
+    uint64_t dfpn_alg_visits = 0;
+    uint64_t dfpn_table_resets = 0;
+
 
     // maximum_feasible() and feasibility computation.
     uint64_t maxfeas_calls = 0;
@@ -103,6 +108,11 @@ struct measure_attr
  
     uint64_t heuristic_visit_hit = 0;
     uint64_t heuristic_visit_miss = 0;
+    uint64_t two_ply_hit = 0;
+    uint64_t dominance_hit = 0;
+    uint64_t dominance_miss = 0;
+    uint64_t tablebase_hit = 0;
+    uint64_t two_ply_miss = 0;
 
     uint64_t five_nine_hits = 0;
     uint64_t five_nine_calls = 0;
@@ -169,6 +179,14 @@ struct measure_attr
 
 	    heuristic_visit_hit += other.heuristic_visit_hit;
 	    heuristic_visit_miss += other.heuristic_visit_miss;
+	    two_ply_hit += other.two_ply_hit;
+	    dominance_hit += other.dominance_hit;
+	    dominance_miss += other.dominance_miss;
+	    tablebase_hit += other.tablebase_hit;
+	    two_ply_miss += other.two_ply_miss;
+	    dfpn_adv_visits += other.dfpn_adv_visits;
+	    dfpn_alg_visits += other.dfpn_alg_visits;
+	    dfpn_table_resets += other.dfpn_table_resets;
 
 	    for (int i = 0; i < SITUATIONS; i++)
 	    {
@@ -202,6 +220,14 @@ struct measure_attr
 	    fprintf(stderr, "--- heuristics --- \n");
 	    double heuristic_visit_ratio = heuristic_visit_hit / (double) (heuristic_visit_miss + heuristic_visit_hit);
 	    fprintf(stderr, "Heuristic visit deeper (by alg): hit: %" PRIu64 ", miss: %" PRIu64 ", ratio %lf.\n", heuristic_visit_hit, heuristic_visit_miss, heuristic_visit_ratio);
+	    fprintf(stderr, "Two-ply visit (by alg): adversary win found: %" PRIu64 ", not found: %" PRIu64 ".\n", two_ply_hit, two_ply_miss);
+	    fprintf(stderr, "Dominance cache (after a miss of the state cache): hit: %" PRIu64 ", miss: %" PRIu64 ".\n", dominance_hit, dominance_miss);
+	    fprintf(stderr, "Endgame tablebase hits: %" PRIu64 ".\n", tablebase_hit);
+	    if (USING_DFPN)
+	    {
+		fprintf(stderr, "Proof-number search: %" PRIu64 " adversary and %" PRIu64 " algorithm visits, %" PRIu64 " table resets.\n",
+			dfpn_adv_visits, dfpn_alg_visits, dfpn_table_resets);
+	    }
 
 	    fprintf(stderr, "Heuristic using known sum of processing times: %" PRIu64 " full hits, %" PRIu64 " partials, %" PRIu64 " misses.\n",
 		    knownsum_full_hit, knownsum_partial_hit, knownsum_miss);
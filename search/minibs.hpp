@@ -48,6 +48,7 @@ public:
 
     void initialize(const binconf& larger_bc)
 	{
+	    items = {};
 	    for (int i = 1; i <= S; i++)
 	    {
 		int shrunk_item = shrink_item(i);
@@ -116,7 +116,7 @@ std::pair<algorithm_vertex *, adv_outedge*> attach_matching_vertex(dag *d, adver
     {
 	// The vertex is not present, and so the edge is not present either.
 	upcoming_alg = d->add_alg_vertex(adv_to_evaluate->bc, next_item);
-	connecting_outedge = qdag->add_adv_outedge(adv_to_evaluate, upcoming_alg, next_item);
+	connecting_outedge = d->add_adv_outedge(adv_to_evaluate, upcoming_alg, next_item);
     } else {
 	
 	// The vertex exists, and so the edge might also exist.  The
@@ -135,7 +135,7 @@ std::pair<algorithm_vertex *, adv_outedge*> attach_matching_vertex(dag *d, adver
 	else
 	{
 	    // create new edge
-	    connecting_outedge = qdag->add_adv_outedge(adv_to_evaluate, upcoming_alg, next_item);
+	    connecting_outedge = d->add_adv_outedge(adv_to_evaluate, upcoming_alg, next_item);
 	}
     }
 
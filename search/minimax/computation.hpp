@@ -73,6 +73,27 @@ public:
     int regrow_level = 0;
     bool evaluation = true;
 
+    // Generation only: the DAG into which the sapling is generated, and the bounds
+    // deciding which of its vertices become tasks.
+    dag *gen_dag = nullptr;
+    task_bounds bounds;
+
+    // Generation only: if positive, fresh adversary vertices at this call depth are not
+    // generated, but stored in the frontier along with the computation state of the path
+    // leading to them (see parallel_generation.hpp).
+    int split_depth = 0;
+    struct frontier_vertex
+    {
+	adversary_vertex *v;
+	uint64_t hash; // The vertex may get deleted by the generation later on.
+	int calldepth;
+	int largest_since_computation_root;
+	bin_int prev_max_feasible;
+	loadconf ol;
+	std::array<int, WEIGHT_HEURISTICS::NUM> bstate_weight_array;
+    };
+    std::vector<frontier_vertex> frontier;
+
     assumptions assumer; // An assumptions cache.
 
 
@@ -116,8 +137,35 @@ public:
 	    }
 	}
 
+    // Prepares the computation for a new task, keeping the allocated memory
+    // (dynprog_data, scaled_items and the arrays) warm. The in-place state
+    // (bstate, ol, scaled items) is set up by explore() itself.
+    // The measurements in meas keep accumulating over all tasks.
+    void reset(int new_task_id)
+	{
+	    task_id = new_task_id;
+	    itemdepth = 0;
+	    calldepth = 0;
+	    largest_since_computation_root = 0;
+	    prev_max_feasible = S;
+	    iterations = 0;
+	    expansion_depth = 0;
+	    explore_root = NULL;
+	    explore_roothash = 0;
+	    overdue_printed = false;
+	    current_overdue = false;
+	    heuristic_regime = false;
+	    heuristic_starting_depth = 0;
+	    current_strategy = NULL;
+	    regrow_level = 0;
+	    evaluation = true;
+	    lih_hit = false;
+	    maxfeas_return_point = -1;
+	}
+
     void check_messages(int task_id);
     victory heuristic_visit_alg(int pres_item);
+    bool two_ply_adv_winning(int pres_item, int bin);
 
     // An experimental unroll of the recursion.
     std::array<int, MAX_RECURSION_DEPTH> unpacked_items = {};
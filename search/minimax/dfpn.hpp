@@ -0,0 +1,446 @@
+#ifndef MINIMAX_DFPN_HPP
+#define MINIMAX_DFPN_HPP 1
+
+// Depth-first proof-number search (df-pn), an alternative exploration engine
+// to the depth-first minimax of recursion.hpp.
+
+// A proof is a win of the adversary, a disproof is a win of the algorithm.
+// Adversary positions are OR nodes, algorithm positions (a binconf plus the
+// presented item) are AND nodes. Solved adversary positions go into adv_cache,
+// which serves as the transposition table of solved positions and is shared with
+// the usual minimax. Proof and disproof numbers of unsolved positions are kept in
+// two tables local to one exploration.
+
+// The search reuses the computation object for everything else: the in-place
+// binconf, the heuristics, maximum_feasible() and the heuristic visit of algorithm
+// vertices, which also supplies the list of moves that need to be searched.
+
+#include <unordered_map>
+
+#include "common.hpp"
+#include "binconf.hpp"
+#include "minimax/computation.hpp"
+#include "minimax/recursion.hpp"
+
+// Proof numbers saturate below PN_INFINITY, so that only solved positions reach it.
+constexpr uint64_t PN_INFINITY = (1ULL << 62);
+
+// The maximum number of unsolved positions kept; both tables are cleared once it is reached.
+constexpr size_t DFPN_TABLE_LIMIT = (1ULL << 22);
+
+struct proof_numbers
+{
+    uint64_t pn = 1;
+    uint64_t dn = 1;
+
+    bool solved() const
+	{
+	    return pn == 0 || dn == 0;
+	}
+};
+
+uint64_t pn_add(uint64_t a, uint64_t b)
+{
+    return std::min(a + b, PN_INFINITY - 1);
+}
+
+const proof_numbers PN_PROVEN = {0, PN_INFINITY};
+const proof_numbers PN_DISPROVEN = {PN_INFINITY, 0};
+
+template <int MINIBS_SCALE> class proof_number_search
+{
+public:
+    computation<minimax::exploring, MINIBS_SCALE> *comp;
+
+    // Unsolved adversary positions, indexed by statehash().
+    std::unordered_map<uint64_t, proof_numbers> adv_table;
+    // Algorithm positions, indexed by alghash() of the presented item.
+    std::unordered_map<uint64_t, proof_numbers> alg_table;
+
+    proof_number_search(computation<minimax::exploring, MINIBS_SCALE> *c) : comp(c)
+	{
+	}
+
+    victory adversary_quick_check(int &heuristical_ub);
+    proof_numbers adversary_child(int item, int target_bin);
+    proof_numbers algorithm_child(int item);
+
+    proof_numbers adversary(uint64_t th_pn, uint64_t th_dn);
+    proof_numbers algorithm(int pres_item, uint64_t th_pn, uint64_t th_dn);
+
+    void store_adversary(uint64_t hash, const proof_numbers& pns);
+    void check_table_limit();
+};
+
+template <int MINIBS_SCALE> void proof_number_search<MINIBS_SCALE>::check_table_limit()
+{
+    if (adv_table.size() + alg_table.size() >= DFPN_TABLE_LIMIT)
+    {
+	MEASURE_ONLY(comp->meas.dfpn_table_resets++);
+	adv_table.clear();
+	alg_table.clear();
+    }
+}
+
+// The same sequence of checks as at the start of computation::adversary() in the exploration mode.
+template <int MINIBS_SCALE> victory proof_number_search<MINIBS_SCALE>::adversary_quick_check(int &heuristical_ub)
+{
+    binconf &bstate = comp->bstate;
+
+    if (USING_HEURISTIC_KNOWNSUM)
+    {
+	int knownsum_response = query_knownsum_heur(bstate.loadhash);
+	if (knownsum_response == 0)
+	{
+	    return victory::alg;
+	} else if (knownsum_response != -1)
+	{
+	    heuristical_ub = knownsum_response;
+	}
+    }
+
+    if (USING_HEURISTIC_WEIGHTSUM)
+    {
+	if (comp->weight_heurs->query_alg_winning(bstate.loadhash, comp->bstate_weight_array))
+	{
+	    return victory::alg;
+	}
+    }
+
+    if (USING_MINIBINSTRETCHING)
+    {
+	if (comp->mbs->query_itemconf_winning(bstate, *(comp->scaled_items)))
+	{
+	    return victory::alg;
+	}
+    }
+
+    if (USING_KNOWNSUM_LOWSEND)
+    {
+	int knownsum_response = query_knownsum_lowest_sendable(bstate.loadhash, bstate.last_item);
+	if (knownsum_response == 0)
+	{
+	    return victory::alg;
+	} else if (knownsum_response != -1)
+	{
+	    heuristical_ub = knownsum_response;
+	}
+    }
+
+    if (ADVERSARY_HEURISTICS)
+    {
+	auto [vic, strategy] = adversary_heuristics<minimax::exploring>(&bstate, comp->dpdata, &(comp->meas), nullptr);
+	if (vic == victory::adv)
+	{
+	    return victory::adv;
+	}
+    }
+
+    comp->iterations++;
+    if (comp->iterations % 1000 == 0)
+    {
+	comp->check_messages(comp->task_id);
+    }
+
+    if (!DISABLE_CACHE)
+    {
+	auto [found, value] = adv_cache->lookup(bstate.statehash());
+	if (found)
+	{
+	    return (value == 0) ? victory::adv : victory::alg;
+	}
+
+	if (USING_DOMINANCE_CACHE)
+	{
+	    victory dominated = dominance_lookup(&bstate);
+	    if (dominated != victory::uncertain)
+	    {
+		return dominated;
+	    }
+	}
+    }
+
+    if (USING_TABLEBASE && tb != nullptr && tb->covers(bstate))
+    {
+	victory tablebase_result = tb->probe(bstate);
+	if (tablebase_result != victory::uncertain)
+	{
+	    return tablebase_result;
+	}
+    }
+
+    return victory::uncertain;
+}
+
+template <int MINIBS_SCALE> void proof_number_search<MINIBS_SCALE>::store_adversary(uint64_t hash, const proof_numbers& pns)
+{
+    if (pns.pn == 0)
+    {
+	adv_table.erase(hash);
+	if (!DISABLE_CACHE)
+	{
+	    adv_cache_encache_adv_win(&(comp->bstate));
+	    if (USING_DOMINANCE_CACHE)
+	    {
+		dominance_encache(&(comp->bstate), victory::adv);
+	    }
+	}
+    } else if (pns.dn == 0)
+    {
+	adv_table.erase(hash);
+	if (!DISABLE_CACHE)
+	{
+	    adv_cache_encache_alg_win(&(comp->bstate));
+	    if (USING_DOMINANCE_CACHE)
+	    {
+		dominance_encache(&(comp->bstate), victory::alg);
+	    }
+	}
+    } else
+    {
+	check_table_limit();
+	adv_table[hash] = pns;
+    }
+}
+
+// Proof numbers of the adversary position after placing item into target_bin.
+template <int MINIBS_SCALE> proof_numbers proof_number_search<MINIBS_SCALE>::adversary_child(int item, int target_bin)
+{
+    uint64_t child_hash = comp->bstate.virtual_hash_with_low(item, target_bin);
+
+    if (!DISABLE_CACHE)
+    {
+	auto [found, value] = adv_cache->lookup(child_hash);
+	if (found)
+	{
+	    return (value == 0) ? PN_PROVEN : PN_DISPROVEN;
+	}
+    }
+
+    auto it = adv_table.find(child_hash);
+    if (it != adv_table.end())
+    {
+	return it->second;
+    }
+
+    return proof_numbers();
+}
+
+// Proof numbers of the algorithm position where item is presented.
+template <int MINIBS_SCALE> proof_numbers proof_number_search<MINIBS_SCALE>::algorithm_child(int item)
+{
+    auto it = alg_table.find(comp->bstate.alghash(item));
+    if (it != alg_table.end())
+    {
+	return it->second;
+    }
+
+    return proof_numbers();
+}
+
+// The OR node. Returns when the position is solved or one of the thresholds is reached.
+template <int MINIBS_SCALE> proof_numbers proof_number_search<MINIBS_SCALE>::adversary(uint64_t th_pn, uint64_t th_dn)
+{
+    MEASURE_ONLY(comp->meas.dfpn_adv_visits++);
+    uint64_t hash = comp->bstate.statehash();
+    int heuristical_ub = S;
+
+    // Positions solved without search are also stored, as the parent
+    // only learns the result through adv_cache.
+    victory quick_check = adversary_quick_check(heuristical_ub);
+    if (quick_check == victory::adv)
+    {
+	store_adversary(hash, PN_PROVEN);
+	return PN_PROVEN;
+    } else if (quick_check == victory::alg)
+    {
+	store_adversary(hash, PN_DISPROVEN);
+	return PN_DISPROVEN;
+    }
+
+    std::vector<int> candidate_moves;
+    int maximum_feasible = compute_next_moves_expstrat<minimax::exploring, MINIBS_SCALE>(candidate_moves, &(comp->bstate),
+											   comp->itemdepth, heuristical_ub, comp);
+
+    proof_numbers current;
+    while (true)
+    {
+	current.pn = PN_INFINITY;
+	current.dn = 0;
+	uint64_t second_pn = PN_INFINITY;
+	int best_item = 0;
+	proof_numbers best;
+
+	for (int item_size : candidate_moves)
+	{
+	    proof_numbers child = algorithm_child(item_size);
+	    if (child.pn < current.pn)
+	    {
+		second_pn = current.pn;
+		current.pn = child.pn;
+		best_item = item_size;
+		best = child;
+	    } else if (child.pn < second_pn)
+	    {
+		second_pn = child.pn;
+	    }
+	    current.dn = pn_add(current.dn, child.dn);
+	}
+
+	// No candidate moves mean that the algorithm has won.
+	if (current.pn == 0)
+	{
+	    current = PN_PROVEN;
+	} else if (current.dn == 0)
+	{
+	    current = PN_DISPROVEN;
+	}
+
+	if (current.solved() || current.pn >= th_pn || current.dn >= th_dn)
+	{
+	    break;
+	}
+
+	uint64_t child_th_pn = std::min(th_pn, pn_add(second_pn, 1));
+	uint64_t child_th_dn = th_dn - current.dn + best.dn;
+
+	adversary_notes notes;
+	adversary_descend<minimax::exploring, MINIBS_SCALE>(comp, notes, best_item, maximum_feasible);
+	algorithm(best_item, child_th_pn, child_th_dn);
+	adversary_ascend<minimax::exploring, MINIBS_SCALE>(comp, notes);
+    }
+
+    store_adversary(hash, current);
+    return current;
+}
+
+// The AND node.
+template <int MINIBS_SCALE> proof_numbers proof_number_search<MINIBS_SCALE>::algorithm(int pres_item, uint64_t th_pn, uint64_t th_dn)
+{
+    MEASURE_ONLY(comp->meas.dfpn_alg_visits++);
+    uint64_t hash = comp->bstate.alghash(pres_item);
+    proof_numbers current;
+
+    // The heuristic visit fills the moves which need to be searched.
+    victory quick_check = victory::uncertain;
+    if (USING_HEURISTIC_VISITS)
+    {
+	quick_check = comp->heuristic_visit_alg(pres_item);
+    } else
+    {
+	comp->simple_fill_moves_alg(pres_item);
+    }
+
+    if (quick_check == victory::uncertain && USING_HEURISTIC_GS)
+    {
+	if (gsheuristic(&(comp->bstate), pres_item, &(comp->meas)) == 1)
+	{
+	    quick_check = victory::alg;
+	}
+    }
+
+    // A copy of the uncertain moves, zero-terminated.
+    std::array<bin_int, BINS+1> moves = {};
+    if (quick_check == victory::uncertain)
+    {
+	for (int pos = 0; pos < BINS; pos++)
+	{
+	    moves[pos] = comp->alg_uncertain_moves[comp->calldepth][pos];
+	    if (moves[pos] == 0)
+	    {
+		break;
+	    }
+	}
+    }
+
+    if (quick_check == victory::adv)
+    {
+	current = PN_PROVEN;
+    } else if (quick_check == victory::alg)
+    {
+	current = PN_DISPROVEN;
+    } else
+    {
+	while (true)
+	{
+	    current.pn = 0;
+	    current.dn = PN_INFINITY;
+	    uint64_t second_dn = PN_INFINITY;
+	    int best_bin = 0;
+	    proof_numbers best;
+
+	    for (int pos = 0; pos < BINS && moves[pos] != 0; pos++)
+	    {
+		proof_numbers child = adversary_child(pres_item, moves[pos]);
+		if (child.dn < current.dn)
+		{
+		    second_dn = current.dn;
+		    current.dn = child.dn;
+		    best_bin = moves[pos];
+		    best = child;
+		} else if (child.dn < second_dn)
+		{
+		    second_dn = child.dn;
+		}
+		current.pn = pn_add(current.pn, child.pn);
+	    }
+
+	    // No moves left mean that the adversary has won.
+	    if (current.dn == 0)
+	    {
+		current = PN_DISPROVEN;
+	    } else if (current.pn == 0)
+	    {
+		current = PN_PROVEN;
+	    }
+
+	    if (current.solved() || current.pn >= th_pn || current.dn >= th_dn)
+	    {
+		break;
+	    }
+
+	    uint64_t child_th_dn = std::min(th_dn, pn_add(second_dn, 1));
+	    uint64_t child_th_pn = th_pn - current.pn + best.pn;
+
+	    algorithm_notes notes;
+	    algorithm_descend<minimax::exploring, MINIBS_SCALE>(comp, notes, pres_item, best_bin);
+	    adversary(child_th_pn, child_th_dn);
+	    algorithm_ascend<minimax::exploring, MINIBS_SCALE>(comp, notes, pres_item);
+	}
+    }
+
+    check_table_limit();
+    alg_table[hash] = current;
+    return current;
+}
+
+// Wrapper for exploration via proof-number search, a counterpart to explore().
+template <int MINIBS_SCALE> victory explore_dfpn(binconf *b, computation<minimax::exploring, MINIBS_SCALE> *comp)
+{
+    b->hashinit();
+
+    binconf root_copy = *b;
+    onlineloads_init(comp->ol, b);
+    comp->eval_start = std::chrono::system_clock::now();
+    comp->current_overdue = false;
+    comp->explore_roothash = b->hash_with_last();
+    comp->explore_root = &root_copy;
+    comp->bstate = *b;
+
+    if (USING_HEURISTIC_WEIGHTSUM)
+    {
+	comp->bstate_weight_array = {};
+    }
+
+    if (USING_MINIBINSTRETCHING)
+    {
+	comp->scaled_items->initialize(comp->bstate);
+    }
+
+    proof_number_search<MINIBS_SCALE> pns(comp);
+    proof_numbers root = pns.adversary(PN_INFINITY, PN_INFINITY);
+    assert(root.solved());
+    return (root.pn == 0) ? victory::adv : victory::alg;
+}
+
+#endif // MINIMAX_DFPN_HPP
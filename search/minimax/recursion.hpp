@@ -19,6 +19,8 @@
 #include "hash.hpp"
 #include "cache/guarantee.hpp"
 #include "cache/state.hpp"
+#include "cache/dominance.hpp"
+#include "tablebase.hpp"
 #include "fits.hpp"
 #include "dynprog/algo.hpp"
 #include "maxfeas.hpp"
@@ -40,6 +42,75 @@
 // victory::alg (quite possible) or all are victory::adv (unlikely),
 // we can return immediately.
 
+// A second ply of the heuristic visit: place pres_item into the given bin and check
+// whether the adversary can answer with a feasible item such that every placement of it
+// is already in the cache as an adversary win. Only cache queries are made, no recursion.
+// If such an item is found, the position after the placement is encached as an adversary win.
+
+template <minimax MODE, int MINIBS_SCALE> bool computation<MODE, MINIBS_SCALE>::two_ply_adv_winning(int pres_item, int bin)
+{
+    bool adv_wins = false;
+    bin_int previously_last_item = bstate.last_item;
+    int bc_new_load_position = bstate.assign_and_rehash(pres_item, bin);
+    int ol_new_load_position = onlineloads_assign(ol, pres_item);
+
+    // Items up to the best fit bound are certainly feasible; above it we only trust the dynprog cache.
+    bin_int lb = onlineloads_bestfit(ol);
+    bin_int ub = std::min((bin_int) ((S*BINS) - bstate.totalload()), prev_max_feasible);
+    bin_int low = lowest_sendable(pres_item);
+    int items_tried = 0;
+
+    for (bin_int item = ub; item >= low && items_tried < TWO_PLY_ITEM_LIMIT && !adv_wins; item--)
+    {
+	if (item > lb)
+	{
+	    if (DISABLE_DP_CACHE)
+	    {
+		continue;
+	    }
+
+	    auto [located, feasible] = pack_and_query(bstate, item);
+	    if (!located || !feasible)
+	    {
+		continue;
+	    }
+	}
+
+	items_tried++;
+	bool all_placements_lose = true;
+	for (int j = 1; j <= BINS; j++)
+	{
+	    if (j > 1 && bstate.loads[j] == bstate.loads[j-1])
+	    {
+		continue;
+	    }
+
+	    if (bstate.loads[j] + item >= R)
+	    {
+		continue;
+	    }
+
+	    auto [found, value] = adv_cache->lookup(bstate.virtual_hash_with_low(item, j));
+	    if (!found || value == 1)
+	    {
+		all_placements_lose = false;
+		break;
+	    }
+	}
+
+	adv_wins = all_placements_lose;
+    }
+
+    if (adv_wins && !DISABLE_CACHE)
+    {
+	adv_cache_encache_adv_win(&bstate);
+    }
+
+    bstate.unassign_and_rehash(pres_item, bc_new_load_position, previously_last_item);
+    onlineloads_unassign(ol, pres_item, ol_new_load_position);
+    return adv_wins;
+}
+
 template <minimax MODE, int MINIBS_SCALE> victory computation<MODE, MINIBS_SCALE>::heuristic_visit_alg(int pres_item)
 {
     victory ret = victory::adv;
@@ -213,6 +284,23 @@ template <minimax MODE, int MINIBS_SCALE> victory computation<MODE, MINIBS_SCALE
 		}
 	    }
 
+	    // Only cache queries two plies below; the minibs and knownsum tables above
+	    // already cover the position one ply below.
+	    if (USING_TWO_PLY_VISITS)
+	    {
+		if (!result_known)
+		{
+		    if (two_ply_adv_winning(pres_item, i))
+		    {
+			MEASURE_ONLY(meas.two_ply_hit++);
+			result_known = true;
+		    } else
+		    {
+			MEASURE_ONLY(meas.two_ply_miss++);
+		    }
+		}
+	    }
+
 	    if (!result_known)
 	    {
 		// At least one uncertainty happened, we set the outcome to uncertain.
@@ -522,18 +610,18 @@ template<minimax MODE, int MINIBS_SCALE> victory computation<MODE, MINIBS_SCALE>
 	if (adv_to_evaluate->state != vert_state::fresh && adv_to_evaluate->state != vert_state::expanding)
 	{
 	    print_if<true>("Assert failed: adversary vertex state is %s.\n", state_name(adv_to_evaluate->state).c_str());
-	    VERTEX_ASSERT(qdag, adv_to_evaluate, (adv_to_evaluate->state == vert_state::fresh || adv_to_evaluate->state == vert_state::expanding)); // no other state should go past this point
+	    VERTEX_ASSERT(gen_dag, adv_to_evaluate, (adv_to_evaluate->state == vert_state::fresh || adv_to_evaluate->state == vert_state::expanding)); // no other state should go past this point
 	}
 
 	// we now do creation of tasks only until the REGROW_LIMIT is reached
 	if (!this->heuristic_regime && this->regrow_level <= REGROW_LIMIT
-	    && POSSIBLE_TASK(adv_to_evaluate, this->largest_since_computation_root, calldepth)
+	    && POSSIBLE_TASK(adv_to_evaluate, this->largest_since_computation_root, calldepth, bounds)
 	    && adv_to_evaluate->out.empty())
 	{
 	    if (DEBUG)
 	    {
 		fprintf(stderr, "Gen: Current conf is a possible task (itemdepth %d, task_depth %d, load %d, task_load %d, comp. root load: %d.\n ",
-	     		itemdepth, task_depth, bstate.totalload(), task_load, computation_root->bc.totalload());
+	     		itemdepth, bounds.depth, bstate.totalload(), bounds.load, bounds.root_load);
 		adv_to_evaluate->print(stderr, true);
 	    }
 
@@ -558,6 +646,15 @@ template<minimax MODE, int MINIBS_SCALE> victory computation<MODE, MINIBS_SCALE>
 
 	     return adv_to_evaluate->win; // previously: return victory::uncertain
 	}
+
+	// The subtrees below the split depth are left to the parallel generation.
+	if (split_depth > 0 && calldepth == split_depth && !this->heuristic_regime
+	    && adv_to_evaluate->out.empty() && adv_to_evaluate->win == victory::uncertain)
+	{
+	    frontier.push_back({adv_to_evaluate, adv_to_evaluate->bc.hash_with_last(), calldepth, largest_since_computation_root,
+		    prev_max_feasible, ol, bstate_weight_array});
+	    return victory::uncertain;
+	}
     }
 
     // If you are exploring, check the global terminate flags every 1000th iteration.
@@ -594,6 +691,29 @@ template<minimax MODE, int MINIBS_SCALE> victory computation<MODE, MINIBS_SCALE>
 		return victory::alg;
 	    }
 	}
+
+	// On a miss, the position may still be dominated by a solved one.
+	if (USING_DOMINANCE_CACHE)
+	{
+	    victory dominated = dominance_lookup(&bstate);
+	    if (dominated != victory::uncertain)
+	    {
+		MEASURE_ONLY(meas.dominance_hit++);
+		return dominated;
+	    }
+	    MEASURE_ONLY(meas.dominance_miss++);
+	}
+    }
+
+    // Positions close to the end of the game are answered by the tablebase, if present.
+    if (EXPLORING && USING_TABLEBASE && tb != nullptr && tb->covers(bstate))
+    {
+	victory tablebase_result = tb->probe(bstate);
+	if (tablebase_result != victory::uncertain)
+	{
+	    MEASURE_ONLY(meas.tablebase_hit++);
+	    return tablebase_result;
+	}
     }
 
    
@@ -621,7 +741,7 @@ template<minimax MODE, int MINIBS_SCALE> victory computation<MODE, MINIBS_SCALE>
 
 	if (GENERATING)
 	{
-	    std::tie(upcoming_alg, new_edge) = attach_matching_vertex(qdag, adv_to_evaluate, item_size);
+	    std::tie(upcoming_alg, new_edge) = attach_matching_vertex(gen_dag, adv_to_evaluate, item_size);
 	}
 
 	adversary_descend<MODE, MINIBS_SCALE>(this, notes, item_size, maximum_feasible);
@@ -638,13 +758,13 @@ template<minimax MODE, int MINIBS_SCALE> victory computation<MODE, MINIBS_SCALE>
 	{
 	    win = victory::adv;
 	    // remove all outedges except the right one
-	    GEN_ONLY(qdag->remove_outedges_except<minimax::generating>(adv_to_evaluate, item_size));
+	    GEN_ONLY(gen_dag->remove_outedges_except<minimax::generating>(adv_to_evaluate, item_size));
 	    break;
 	    
 	} else if (below == victory::alg)
 	{
 	    // no decreasing, but remove this branch of the game tree
-	    GEN_ONLY(qdag->remove_edge<minimax::generating>(new_edge));
+	    GEN_ONLY(gen_dag->remove_edge<minimax::generating>(new_edge));
 	} else if (below == victory::uncertain)
 	{
 	    assert(GENERATING);
@@ -666,7 +786,11 @@ template<minimax MODE, int MINIBS_SCALE> victory computation<MODE, MINIBS_SCALE>
 	{
 	    adv_cache_encache_alg_win(&bstate);
 	}
-	
+
+	if (USING_DOMINANCE_CACHE && (win == victory::adv || win == victory::alg))
+	{
+	    dominance_encache(&bstate, win);
+	}
     }
 
     // If we were in heuristics mode, switch back to normal.
@@ -841,7 +965,7 @@ template<minimax MODE, int MINIBS_SCALE> victory computation<MODE, MINIBS_SCALE>
 	if (GENERATING)
 	{
 	    std::tie(upcoming_adv, connecting_outedge) =
-		attach_matching_vertex(qdag, alg_to_evaluate, &bstate, i);
+		attach_matching_vertex(gen_dag, alg_to_evaluate, &bstate, i);
 	}
 
 	below = adversary(upcoming_adv, alg_to_evaluate);
@@ -868,7 +992,7 @@ template<minimax MODE, int MINIBS_SCALE> victory computation<MODE, MINIBS_SCALE>
 
 		// Does not delete the algorithm vertex itself,
 		// because we created it on a higher level of recursion.
-		qdag->remove_outedges<minimax::generating>(alg_to_evaluate);
+		gen_dag->remove_outedges<minimax::generating>(alg_to_evaluate);
 		// assert(current_algorithm == NULL); // sanity check
 
 		alg_to_evaluate->win = victory::alg;
@@ -949,6 +1073,8 @@ template <minimax MODE, int MINIBS_SCALE> victory explore(binconf *b, computatio
 template <minimax MODE, int MINIBS_SCALE> victory generate(sapling start_sapling,
 		computation<MODE, MINIBS_SCALE> *comp)
 {
+    assert(comp->gen_dag != nullptr);
+    comp->bounds.root_load = start_sapling.root->bc.totalload();
     duplicate(&(comp->bstate), &start_sapling.root->bc);
     comp->bstate.hashinit();
     comp->itemdepth = comp->bstate.itemcount_explicit();
@@ -0,0 +1,149 @@
+#ifndef _MPMC_QUEUE_HPP
+#define _MPMC_QUEUE_HPP 1
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+
+// A bounded lock-free queue with any number of pushers and pullers (D. Vyukov's ring).
+// Every cell has a sequence number: a cell at position pos is free for the push of pos
+// if its sequence is pos, and holds the element for the pop of pos if its sequence is pos+1.
+// A thread claims a position by a compare-and-swap on the head or tail, so the only
+// contention is between threads on the same end of the queue.
+
+// The capacity is rounded up to a power of two. init() and clear() are not thread-safe,
+// the queue is set up between rounds while nobody uses it.
+template <class T> class mpmc_queue
+{
+public:
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct cell
+    {
+	std::atomic<size_t> sequence;
+	T data;
+    };
+
+    cell *cells = nullptr;
+    size_t mask = 0;
+    alignas(CACHE_LINE) std::atomic<size_t> tail{0}; // The position of the next push.
+    alignas(CACHE_LINE) std::atomic<size_t> head{0}; // The position of the next pop.
+
+    mpmc_queue() {}
+
+    mpmc_queue(size_t capacity)
+	{
+	    init(capacity);
+	}
+
+    ~mpmc_queue()
+	{
+	    delete[] cells;
+	}
+
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    void init(size_t capacity)
+	{
+	    size_t rounded = 2;
+	    while (rounded < capacity)
+	    {
+		rounded <<= 1;
+	    }
+
+	    delete[] cells;
+	    cells = new cell[rounded];
+	    mask = rounded - 1;
+	    for (size_t i = 0; i < rounded; i++)
+	    {
+		cells[i].sequence.store(i, std::memory_order_relaxed);
+	    }
+	    tail.store(0, std::memory_order_relaxed);
+	    head.store(0, std::memory_order_relaxed);
+	}
+
+    void clear()
+	{
+	    delete[] cells;
+	    cells = nullptr;
+	    mask = 0;
+	    tail.store(0, std::memory_order_relaxed);
+	    head.store(0, std::memory_order_relaxed);
+	}
+
+    size_t capacity() const
+	{
+	    return cells == nullptr ? 0 : mask + 1;
+	}
+
+    // Returns false if the queue is full.
+    bool push(const T& element)
+	{
+	    size_t pos = tail.load(std::memory_order_relaxed);
+	    while (true)
+	    {
+		cell *c = &cells[pos & mask];
+		size_t seq = c->sequence.load(std::memory_order_acquire);
+		intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+		if (diff == 0)
+		{
+		    if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+		    {
+			c->data = element;
+			c->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		    }
+		} else if (diff < 0)
+		{
+		    return false;
+		} else
+		{
+		    pos = tail.load(std::memory_order_relaxed);
+		}
+	    }
+	}
+
+    // Returns false if the queue is empty.
+    bool pop(T& element)
+	{
+	    size_t pos = head.load(std::memory_order_relaxed);
+	    while (true)
+	    {
+		cell *c = &cells[pos & mask];
+		size_t seq = c->sequence.load(std::memory_order_acquire);
+		intptr_t diff = (intptr_t) seq - (intptr_t) (pos + 1);
+		if (diff == 0)
+		{
+		    if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+		    {
+			element = c->data;
+			c->sequence.store(pos + mask + 1, std::memory_order_release);
+			return true;
+		    }
+		} else if (diff < 0)
+		{
+		    return false;
+		} else
+		{
+		    pos = head.load(std::memory_order_relaxed);
+		}
+	    }
+	}
+
+    // The number of elements, exact only when no other thread is using the queue.
+    size_t size() const
+	{
+	    size_t t = tail.load(std::memory_order_acquire);
+	    size_t h = head.load(std::memory_order_acquire);
+	    return t > h ? t - h : 0;
+	}
+
+    bool empty() const
+	{
+	    return size() == 0;
+	}
+};
+
+#endif // _MPMC_QUEUE_HPP
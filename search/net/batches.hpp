@@ -12,48 +12,49 @@ class batches
 
 public:
     int active_batches = 0;
-    int (*b)[BATCH_SIZE] = nullptr;
+    std::vector<std::vector<int>> b;
     batches(int overseer_count)
 	{
 	    active_batches = overseer_count+1;
-	    b = new int[active_batches][BATCH_SIZE];
+	    b.resize(active_batches);
 	}
 
-    ~batches()
-	{
-	    delete[] b;
-	}
-
-
     void clear()
 	{
 	    for (int i = 0; i < active_batches; i++)
 	    {
-		for (int j = 0; j < BATCH_SIZE; j++)
-		{
-		    b[i][j] = -1;
-		}
+		b[i].clear();
 	    }
 	}
 
+    // The size of the next batch: the size requested by the overseer, but smaller
+    // near the end of the queue, so that the remaining tasks are spread among all overseers
+    // and no overseer is left with a long tail of tasks.
+    static int batch_size(int requested, int task_status_pointer, int task_count, int overseer_count)
+	{
+	    int remaining = task_count - task_status_pointer;
+	    int fair_share = remaining / (2 * overseer_count);
+	    return std::max(MIN_BATCH_SIZE, std::min(requested, fair_share));
+	}
+
     void compose_batch(int batch_index, int& task_status_pointer, int task_count,
-		       std::atomic<task_status> *task_status_array)
+		       std::atomic<task_status> *task_status_array, int size)
 	{
-	    int i = 0;
-	    while (i < BATCH_SIZE)
+	    b[batch_index].clear();
+	    while ((int) b[batch_index].size() < size)
 	    {
 
 		if (task_status_pointer >= tcount)
 		{
 		    // no more tasks to send out
-		    b[batch_index][i] = NO_MORE_TASKS;
+		    b[batch_index].push_back(NO_MORE_TASKS);
 		} else
 		{
 		    task_status status = task_status_array[task_status_pointer].load(std::memory_order_acquire);
 		    if (status == task_status::available)
 		    {
 			print_if<TASK_DEBUG>("Added task %d into the next batch.\n", taskpointer);
-			b[batch_index][i] = taskpointer;
+			b[batch_index].push_back(taskpointer);
 			taskpointer++;
 		    } else {
 			print_if<TASK_DEBUG>("Task %d has status %d, skipping.\n", taskpointer, status);
@@ -61,8 +62,7 @@ public:
 			continue;
 		    }
 		}
-		assert(b[batch_index][i] >= -1 && b[batch_index][i] < tcount);
-		i++;
+		assert(b[batch_index].back() >= -1 && b[batch_index].back() < tcount);
 	    }
 	}
 };
@@ -0,0 +1,8 @@
+#pragma once
+// Include all classes and global functions of the local (thread-based) mode.
+// A counterpart of net/mpi.hpp, selected by ./compile.sh --local.
+#include "./local/multiprocess.hpp"
+#include "./local/communicator.hpp"
+#include "./local/comm_basics.hpp"
+#include "./local/qcomm.hpp"
+#include "./local/ocomm.hpp"
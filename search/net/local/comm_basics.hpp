@@ -1,62 +1,72 @@
 #pragma once
 
 // Basic functions of the local communicator.
-// The following functions should be implemented here:
-
-// void deferred_construction(int worldsize);
-// void allocate_overseer_map();
-// ~communicator();
-// void reset_runlows();
-// bool is_running_low(int target_overseer);
-// void satisfied_runlow(int target_overseer);
-// std::string machine_name();
-// void sync_after_initialization();
-// bool round_start_and_finality();
-// void round_start_and_finality(bool finality);
-// void sync_after_round_end();
-// void bcast_send_int(int root_sender, int num);
-// int bcast_recv_int(int root_sender);
-// void bcast_send_int_array(int root_sender, int* array, int length);
-// std::pair<int, int*> bcast_recv_int_array(int root_sender);
-// void bcast_send_uint64_array(int root_sender, uint64_t* array, int length);
-// std::pair<int, uint64_t*> bcast_recv_uint64_array(int root_sender);
-// void bcast_send_tcount(int tc);
-// int bcast_recv_tcount();
-// flat_task bcast_recv_flat_task();
-// void bcast_send_flat_task(flat_task& ft);
-// void bcast_send_zobrist(zobrist_quintuple zq);
-// zobrist_quintuple bcast_recv_and_allocate_zobrist();
-// void send_number_of_workers(int num_workers);
-// std::pair<int,int> learn_worker_rank();
-// void compute_thread_ranks();
-// void transmit_measurements(measure_attr& meas);
-// void receive_measurements();
-// void send_root_solved();
-
-// First, machine name. This is surprisingly tricky, so we hardcode it for now.
-
-std::string communicator::machine_name()
-{
-    return std::string("t1000");
-}
-
-// Next, Zobrist functions. Since Zobrist arrays are computed in advance and afterwards
-// only used in a read-only mode, we can just access them concurrently with no worries.
-// Thus, the functions do nothing.
-void communicator::bcast_send_zobrist(zobrist_quintuple zq)
+
+// Both the queen and the overseer call deferred_construction(), so it only allocates once.
+void communicator::deferred_construction()
 {
+    std::call_once(constructed, [&]() {
+	running_low = new bool[multiprocess::world_size];
+	requested_batch_size = new int[multiprocess::world_size];
+	runlow_requests.deferred_construction(multiprocess::world_size);
+	batches.deferred_construction(multiprocess::world_size);
+	solutions.deferred_construction(multiprocess::world_size);
+	timings.deferred_construction(multiprocess::world_size);
+	reset_runlows();
+    });
+
+    std::string name = gethost();
+    print_if<PROGRESS>("Thread with rank %d reporting for duty: %s, %d threads communicating locally.\n",
+		       multiprocess::world_rank, name.c_str(), multiprocess::world_size);
 }
 
-void communicator::bcast_recv_and_assign_zobrist()
+void communicator::allocate_overseer_map()
 {
+    assert(worker_world_size > 0);
+    overseer_map = new int[worker_world_size];
 }
 
+communicator::~communicator()
+{
+    delete[] running_low;
+    delete[] requested_batch_size;
+    delete[] overseer_map;
+}
 
-bool communicator::round_start_and_finality()
+void communicator::reset_runlows()
+{
+    for (int i = 0; i < multiprocess::world_size; i++)
+    {
+	running_low[i] = false;
+    }
+}
+
+bool communicator::is_running_low(int target_overseer)
+{
+    return running_low[target_overseer];
+}
+
+int communicator::requested_size(int target_overseer)
 {
-    int final_flag_int;
-    MPI_Bcast(&final_flag_int, 1, MPI_INT, QUEEN, MPI_COMM_WORLD);
-    return (bool) final_flag_int;
+    return requested_batch_size[target_overseer];
+}
+
+void communicator::satisfied_runlow(int target_overseer)
+{
+    running_low[target_overseer] = false;
+}
+
+// Zobrist arrays are computed by the queen and afterwards only used in a read-only mode,
+// so they can be accessed concurrently with no worries. We only make sure the overseer
+// does not read them before they are computed.
+void communicator::bcast_send_zobrist(zobrist_quintuple zq)
+{
+    zobrist_ready.sync_up();
+}
+
+void communicator::bcast_recv_and_assign_zobrist()
+{
+    zobrist_ready.sync_up();
 }
 
 // function that starts the round (called by queen, finality set to true when round is final)
@@ -68,8 +78,7 @@ void communicator::round_start_and_finality(bool finality)
 // function that waits for round start (called by overseers)
 bool communicator::round_start_and_finality()
 {
-    bool finality = round_finality.recv();
-    return finality;
+    return round_finality.receive();
 }
 
 void communicator::sync_after_round_end()
@@ -82,7 +91,7 @@ void communicator::sync_after_initialization()
     initialization_end.sync_up();
 }
 
-
+// The task count also serves as the signal that the shared task array and statuses are ready.
 void communicator::bcast_send_tcount(int tc)
 {
     tcount_broadcaster.send(tc);
@@ -90,6 +99,81 @@ void communicator::bcast_send_tcount(int tc)
 
 int communicator::bcast_recv_tcount()
 {
-    return tcount_broadcaster.recv();
+    return tcount_broadcaster.receive();
+}
+
+// The task array and task statuses are shared, so the following transfers are empty.
+void communicator::bcast_send_tstatus_transport(int *tstatus_transport, int tstatus_length)
+{
+}
+
+void communicator::bcast_recv_allocate_tstatus_transport(int **tstatus_transport_memory)
+{
+    *tstatus_transport_memory = nullptr;
+}
+
+void communicator::delete_tstatus_transport(int **tstatus_transport)
+{
+}
+
+void communicator::bcast_send_flat_task(flat_task& ft)
+{
+}
+
+flat_task communicator::bcast_recv_flat_task()
+{
+    return flat_task();
 }
 
+void communicator::bcast_send_tasks(const task *tasks, int count)
+{
+}
+
+void communicator::bcast_recv_tasks(task *tasks, int count)
+{
+}
+
+// Overseers use the next two functions to learn the size of the overall worker pool.
+void communicator::send_number_of_workers(int num_workers)
+{
+    this->num_of_workers = num_workers;
+    worker_count_broadcaster.send(num_workers);
+}
+
+std::pair<int,int> communicator::learn_worker_rank()
+{
+    worker_world_size = num_of_workers;
+    print_if<VERBOSE>("Overseer %d has %d threads, ranked [%d,%d] of %d total.\n",
+		      multiprocess::world_rank, this->num_of_workers, 0,
+		      worker_count - 1, worker_world_size);
+    return std::pair(0, worker_world_size);
+}
+
+// With a single overseer, all workers belong to it.
+void communicator::compute_thread_ranks()
+{
+    thread_rank_size = worker_count_broadcaster.receive();
+    overseer_map = new int[thread_rank_size];
+    for (int i = 0; i < thread_rank_size; i++)
+    {
+	overseer_map[i] = multiprocess::OVERSEER_ID;
+    }
+}
+
+// The overseer adds its measurements directly; the queen waits until it is done.
+void communicator::transmit_measurements(measure_attr& meas)
+{
+    g_meas.add(meas);
+    measurements_added.sync_up();
+}
+
+void communicator::receive_measurements()
+{
+    measurements_added.sync_up();
+}
+
+void communicator::send_root_solved()
+{
+    print_if<COMM_DEBUG>("Queen: Sending root solved to the overseer.\n");
+    root_solved_signal.store(true);
+}
@@ -1,84 +1,99 @@
 #pragma once
 
-// In the "local" networking mode, all overseers are on the same computer
-// (a reasonable choice is to have only one) and communication is implemented
-// via std::thread and other standard concurrent programming tools of C++.
+// In the "local" networking mode, the queen and the overseer are threads of one process
+// and communication is implemented via std::thread and other standard concurrent
+// programming tools of C++.
 
-// We store all of the locks needed for communication in the communicator class.
+// The task array, the task statuses, the Zobrist arrays and the dynamic programming
+// cache are shared between the two threads, so nothing is serialized. What remains are
+// the signals between the threads, all of which are stored in the communicator.
 
 #include <cstdio>
 #include <cstdlib>
 #include <cassert>
 #include <thread>
 #include <chrono>
+#include <mutex>
 
 #include "../../common.hpp"
+#include "../../measure_structures.hpp"
 #include "../../dag/dag.hpp"
 #include "../../hash.hpp"
 #include "../../tasks.hpp"
 
-#include "brodadcaster.hpp"
+#include "broadcaster.hpp"
 #include "synchronizer.hpp"
 #include "message_arrays.hpp"
-#include "comm_basics.hpp"
 
 // ----
 const int SYNCHRO_SLEEP = 20;
 constexpr int COMMUNICATING_THREADS = 2;
 
+// Starting signal: either "change monotonicity" or "terminate".
+const int TERMINATION_SIGNAL = -1;
+
+// Ending signal: always "root solved", does not terminate.
+const int ROOT_SOLVED_SIGNAL = -2;
+const int ROOT_UNSOLVED_SIGNAL = -3;
+
 class communicator
 {
-private:
-
-    broadcaster<COMMUNICATING_THREADS, bool> round_finality;
-    broadcaster<COMMUNICATING_THREADS, int> tcount_broadcaster;
-    broadcaster<COMMUNICATING_THREADS, flat_task> flat_task_broadcaster;
-    
+    int worker_world_size = 0;
+    int num_of_workers = 0;
+    bool *running_low = NULL;
+    int *requested_batch_size = NULL; // the batch size requested by each overseer when running low
+    int* overseer_map = NULL; // a quick map from workers to overseer
+    std::once_flag constructed;
+
+    broadcaster<bool> round_finality;
+    broadcaster<int> tcount_broadcaster;
+    broadcaster<int> worker_count_broadcaster;
+
+    synchronizer<COMMUNICATING_THREADS> zobrist_ready;
     synchronizer<COMMUNICATING_THREADS> initialization_end;
     synchronizer<COMMUNICATING_THREADS> round_end;
+    synchronizer<COMMUNICATING_THREADS> measurements_added;
+
+    // Non-blocking messages, indexed by the recipient.
+    message_arrays<std::pair<int, int>> runlow_requests; // (sender, requested batch size)
+    message_arrays<std::vector<int>> batches;
+    message_arrays<std::vector<int>> solutions;
+    message_arrays<std::vector<int>> timings;
 
-    std::array<std::atomic<bool>, COMMUNICATING_THREADS> running_low;
-    
     // Root solved -- a non-blocking signal.
-    std::atomic<bool> root_solved_signal;
-    
-   
-public:
+    std::atomic<bool> root_solved_signal{false};
 
+public:
     // Located in: net/local/comm_basics.hpp
-    void deferred_construction(int worldsize);
+    void deferred_construction();
     void allocate_overseer_map();
     ~communicator();
     void reset_runlows();
     bool is_running_low(int target_overseer);
+    int requested_size(int target_overseer);
     void satisfied_runlow(int target_overseer);
-    std::string machine_name();
 
     void sync_after_initialization();
-    
+
     bool round_start_and_finality();
     void round_start_and_finality(bool finality);
     void sync_after_round_end();
 
-    // void bcast_send_monotonicity(int m);
-    // int bcast_recv_monotonicity();
     void bcast_send_tcount(int tc);
     int bcast_recv_tcount();
 
     void bcast_send_tstatus_transport(int *tstatus, int tstatus_length);
     void bcast_recv_allocate_tstatus_transport(int **tstatus_transport_pointer);
-    // We delete the local copy via communicator as a "hack" that allows
-    // the local mode to just pass and not delete anything.
     void delete_tstatus_transport(int **tstatus_transport);
 
     flat_task bcast_recv_flat_task();
     void bcast_send_flat_task(flat_task& ft);
-
+    void bcast_send_tasks(const task *tasks, int count);
+    void bcast_recv_tasks(task *tasks, int count);
 
     void bcast_send_zobrist(zobrist_quintuple zq);
     void bcast_recv_and_assign_zobrist();
 
-
     void send_number_of_workers(int num_workers);
     std::pair<int,int> learn_worker_rank();
     void compute_thread_ranks();
@@ -87,18 +102,42 @@ public:
     void receive_measurements();
     void send_root_solved();
 
-
     // Located in: net/local/ocomm.hpp
     void ignore_additional_signals();
-    void check_root_solved();
+    bool check_root_solved(std::vector<worker_flags*>& w_flags);
     void send_solution_pair(int ftask_id, int solution);
-    void request_new_batch(int overseer_id);
-    bool try_receiving_batch(std::array<int, BATCH_SIZE>& upcoming_batch);
+    void send_solutions(const std::vector<int>& solution_pairs);
+    void send_task_timings(const std::vector<int>& timings, int round);
+    int receive_pruned_tasks(std::atomic<task_status> *task_status_array, int round,
+			     std::vector<int> *received_ids = nullptr);
+    void request_new_batch(int requested_size);
+    int try_receiving_batch(std::array<int, MAX_BATCH_SIZE>& upcoming_batch);
+    void send_steal_request(int victim, int round);
+    int check_steal_request(int &round);
+    void send_stolen_tasks(int thief, int round, const std::vector<int>& stolen);
+    int try_receiving_stolen_tasks(int round, std::vector<int>& stolen);
 
     // Located in: net/local/qcomm.hpp
-    void send_batch(int *batch, int target_overseer);
+    void send_batch(const std::vector<int>& batch, int target_overseer);
     void collect_runlows();
+    bool collect_solutions(std::vector<int>& solution_pairs);
+    bool collect_task_timings(std::vector<int>& timings, int round);
     void ignore_additional_solutions();
+    void send_pruned_tasks(const std::vector<int>& pruned, int round);
+
+    // The one-sided transport of net/mpi/rma.hpp has nothing to do here,
+    // as the task statuses are shared already.
+    void rma_open_window(int task_count) {}
+    void rma_close_window() {}
+    void rma_store_solutions(const std::vector<int>& solution_pairs)
+	{
+	    send_solutions(solution_pairs);
+	}
+    void rma_publish_pruned(const std::vector<int>& pruned, int round) {}
+    int rma_fetch_pruned(std::atomic<task_status> *task_status_array, int round)
+	{
+	    return 0;
+	}
 };
 
 // A global variable facilitating the communication in local mode.
@@ -2,22 +2,23 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 // Message arrays for non-blocking sending and receiving objects of one type.
 // They need to be cleared manually.
 template <class DATA> class message_arrays
 {
 private:
-    int reader_count;
-    std::mutex* access;
-    std::vector<DATA> *arrays;
-    size_t* positions;
+    int reader_count = 0;
+    std::mutex* access = nullptr;
+    std::vector<DATA> *arrays = nullptr;
+    size_t* positions = nullptr;
 public:
     void deferred_construction(int tc)
 	{
 	    reader_count = tc;
 	    arrays = new std::vector<DATA>[tc];
-	    positions = new size_t[tc];
+	    positions = new size_t[tc]();
 	    access = new std::mutex[tc];
 	}
 
@@ -34,6 +35,7 @@ public:
 	    {
 		std::unique_lock<std::mutex> lk(access[i]);
 		arrays[i].clear();
+		positions[i] = 0;
 		lk.unlock();
 	    }
 	}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cassert>
+#include <thread>
+#include <vector>
+
+// Main start and stop for the local mode, where the queen and the overseer are threads
+// of a single process. The interface mirrors net/mpi/multiprocess.hpp.
+
+// There is always exactly one overseer: it already owns all worker threads of the machine,
+// and a second one would only duplicate the caches which the workers share.
+class multiprocess
+{
+public:
+    // Each thread has its own rank: the queen 0 and the overseer 1. Threads spawned
+    // later (workers, the updater) start with rank 0; they only use it for printing.
+    static thread_local int world_rank;
+    static int world_size;
+    static constexpr int QUEEN_ID = 0;
+    static constexpr int OVERSEER_ID = 1;
+    static std::thread overseer_thread;
+
+    static bool queen_only()
+	{
+	    return world_size == 1;
+	}
+    static bool is_queen()
+	{
+	    return world_rank == 0;
+	}
+
+    // There are no sub-queens in the local mode.
+    static bool is_subqueen(int rank)
+	{
+	    return false;
+	}
+
+    static int parent(int rank = world_rank)
+	{
+	    return QUEEN_ID;
+	}
+
+    static std::vector<int> children(int rank = world_rank)
+	{
+	    if (rank == QUEEN_ID)
+	    {
+		return {OVERSEER_ID};
+	    }
+	    return {};
+	}
+
+    static int overseer_count()
+	{
+	    return multiprocess::world_size - 1;
+	}
+
+    static void init()
+	{
+	    world_size = 2;
+	    world_rank = QUEEN_ID;
+	}
+
+    // Starts the overseer in a new thread and continues as the queen.
+    static void split(void (*queen_function)(int, char**), void (*overseer_function)(int, char**),
+    int argc, char** argv)
+	{
+	    overseer_thread = std::thread([=]() {
+		world_rank = OVERSEER_ID;
+		overseer_function(argc, argv);
+	    });
+
+	    queen_function(argc, argv);
+	}
+
+    static void join()
+	{
+	    overseer_thread.join();
+	}
+};
+
+thread_local int multiprocess::world_rank = 0;
+int multiprocess::world_size = 0;
+std::thread multiprocess::overseer_thread;
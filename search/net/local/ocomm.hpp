@@ -0,0 +1,91 @@
+#ifndef _NET_LOCAL_OCOMM_HPP
+#define _NET_LOCAL_OCOMM_HPP 1
+
+// Local communication methods used by the overseer.
+
+// The overseer drops signals which arrived after the end of the round.
+void communicator::ignore_additional_signals()
+{
+    root_solved_signal.store(false);
+    batches.clear();
+}
+
+bool communicator::check_root_solved(std::vector<worker_flags*>& w_flags)
+{
+    if (root_solved_signal.exchange(false))
+    {
+	for (unsigned int i = 0; i < w_flags.size(); i++)
+	{
+	    w_flags[i]->root_solved = true;
+	}
+	return true;
+    }
+    return false;
+}
+
+// The workers have already written the results into the shared task statuses;
+// the queen still needs to learn which tasks finished, so that it runs the updater.
+void communicator::send_solution_pair(int ftask_id, int solution)
+{
+    solutions.send(multiprocess::QUEEN_ID, {ftask_id, solution});
+}
+
+void communicator::send_solutions(const std::vector<int>& solution_pairs)
+{
+    solutions.send(multiprocess::QUEEN_ID, solution_pairs);
+}
+
+// The message starts with the round number, as the task ids are only valid within the round.
+void communicator::send_task_timings(const std::vector<int>& timings_pairs, int round)
+{
+    std::vector<int> message(1, round);
+    message.insert(message.end(), timings_pairs.begin(), timings_pairs.end());
+    timings.send(multiprocess::QUEEN_ID, message);
+}
+
+// The queen marks the pruned tasks in the shared task statuses, where the workers see them.
+int communicator::receive_pruned_tasks(std::atomic<task_status> *task_status_array, int round,
+				       std::vector<int> *received_ids)
+{
+    return 0;
+}
+
+void communicator::request_new_batch(int requested_size)
+{
+    runlow_requests.send(multiprocess::QUEEN_ID, std::make_pair(multiprocess::world_rank, requested_size));
+}
+
+// Returns the number of tasks received, zero if no batch arrived.
+int communicator::try_receiving_batch(std::array<int, MAX_BATCH_SIZE>& upcoming_batch)
+{
+    auto [received, batch] = batches.try_pop(multiprocess::world_rank);
+    if (!received)
+    {
+	return 0;
+    }
+
+    assert(batch.size() <= MAX_BATCH_SIZE);
+    std::copy(batch.begin(), batch.end(), upcoming_batch.begin());
+    return batch.size();
+}
+
+// There is only one overseer, so there is nobody to steal from.
+void communicator::send_steal_request(int victim, int round)
+{
+}
+
+int communicator::check_steal_request(int &round)
+{
+    return -1;
+}
+
+void communicator::send_stolen_tasks(int thief, int round, const std::vector<int>& stolen)
+{
+}
+
+int communicator::try_receiving_stolen_tasks(int round, std::vector<int>& stolen)
+{
+    return -1;
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef _NET_LOCAL_QCOMM_HPP
+#define _NET_LOCAL_QCOMM_HPP 1
+
+// Local communication methods used by the queen.
+
+void communicator::send_batch(const std::vector<int>& batch, int target_overseer)
+{
+    assert(batch.size() <= MAX_BATCH_SIZE);
+    batches.send(target_overseer, batch);
+}
+
+void communicator::collect_runlows()
+{
+    auto [received, request] = runlow_requests.try_pop(multiprocess::QUEEN_ID);
+    while (received)
+    {
+	running_low[request.first] = true;
+	requested_batch_size[request.first] = request.second;
+	std::tie(received, request) = runlow_requests.try_pop(multiprocess::QUEEN_ID);
+    }
+}
+
+// Appends all (task id, status) pairs reported so far. Returns false if there were none.
+bool communicator::collect_solutions(std::vector<int>& solution_pairs)
+{
+    bool collected = false;
+    auto [received, pairs] = solutions.try_pop(multiprocess::QUEEN_ID);
+    while (received)
+    {
+	collected = true;
+	solution_pairs.insert(solution_pairs.end(), pairs.begin(), pairs.end());
+	std::tie(received, pairs) = solutions.try_pop(multiprocess::QUEEN_ID);
+    }
+    return collected;
+}
+
+// Appends all (task id, milliseconds) pairs of the given round reported so far; messages
+// of an earlier round are dropped. Returns false if there were no pairs of the round.
+bool communicator::collect_task_timings(std::vector<int>& timings_pairs, int round)
+{
+    bool collected = false;
+    auto [received, message] = timings.try_pop(multiprocess::QUEEN_ID);
+    while (received)
+    {
+	if (message.size() > 1 && message[0] == round)
+	{
+	    collected = true;
+	    timings_pairs.insert(timings_pairs.end(), message.begin() + 1, message.end());
+	}
+	std::tie(received, message) = timings.try_pop(multiprocess::QUEEN_ID);
+    }
+    return collected;
+}
+
+// Queen drops the remaining messages from the previous round.
+void communicator::ignore_additional_solutions()
+{
+    solutions.clear();
+    timings.clear();
+    runlow_requests.clear();
+}
+
+// The pruned status is already visible in the shared task statuses.
+void communicator::send_pruned_tasks(const std::vector<int>& pruned, int round)
+{
+}
+
+void collect_worker_tasks()
+{
+    std::vector<int> solution_pairs;
+    if (comm.collect_solutions(solution_pairs))
+    {
+	apply_solution_pairs(solution_pairs.data(), solution_pairs.size());
+    }
+}
+
+#endif
@@ -9,29 +9,27 @@
 template <int TOTAL_THREADS> class synchronizer
 {
     int waiting_to_sync = 0;
+    // Counts the completed synchronizations, which protects against spurious wakeups.
+    uint64_t generation = 0;
     std::mutex sync_mutex;
     std::condition_variable cv;
 
 public:
     void sync_up()
 	{
-	    bool all_waiting = false;
 	    std::unique_lock<std::mutex> lk(sync_mutex);
 	    waiting_to_sync++;
 	    if (waiting_to_sync == TOTAL_THREADS)
 	    {
-		all_waiting = true;
 		waiting_to_sync = 0;
-	    }
-	    if (all_waiting)
-	    {
+		generation++;
 		lk.unlock();
 		cv.notify_all();
 	    }
 	    else
 	    {
-		cv.wait(lk);
-		lk.unlock();
+		uint64_t our_generation = generation;
+		cv.wait(lk, [&] { return generation != our_generation; });
 	    }
 	}
 };
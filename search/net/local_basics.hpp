@@ -1,11 +0,0 @@
-#ifndef _NET_LOCAL_BASICS
-#define _NET_LOCAL_BASICS 1
-
-// In the local regime, it is assumed the communicator is a global
-// structure which provides the locking mechanisms.
-
-class communicator
-{
-}
-    
-#endif
@@ -5,3 +5,4 @@
 #include "./mpi/comm_basics.hpp"
 #include "./mpi/qcomm.hpp"
 #include "./mpi/ocomm.hpp"
+#include "./mpi/rma.hpp"
@@ -157,11 +157,13 @@ void communicator::receive_measurements()
     }
 }
 
+// Sent to the children only; a sub-queen passes the signal on to its overseers
+// after its last batch, so that no batch arrives after the end of the round.
 void communicator::send_root_solved()
 {
-    for (int i = 1; i < multiprocess::world_size; i++)
+    for (int i : multiprocess::children())
     {
-	print_if<COMM_DEBUG>("Queen: Sending root solved to overseer %d.\n", i);
+	print_if<COMM_DEBUG>("Process %d: Sending root solved to %d.\n", multiprocess::world_rank, i);
 	MPI_Send(&ROOT_SOLVED_SIGNAL, 1, MPI_INT, i, net::ROOT_SOLVED, MPI_COMM_WORLD);
     }
 }
@@ -245,6 +247,38 @@ flat_task communicator::bcast_recv_flat_task()
     return ret;
 }
 
+// Bulk transfer of the whole task array. The serialized buffer is sent in large chunks,
+// as the count argument of MPI_Bcast is an int.
+void communicator::bcast_send_tasks(const task *tasks, int count)
+{
+    std::vector<uint8_t> buffer;
+    serialize_tasks(tasks, count, buffer);
+    uint64_t length = buffer.size();
+    MPI_Bcast(&length, 1, MPI_UNSIGNED_LONG, multiprocess::QUEEN_ID, MPI_COMM_WORLD);
+    for (uint64_t start = 0; start < length; start += BROADCAST_CHUNK_BYTES)
+    {
+	int chunk = (int) std::min((uint64_t) BROADCAST_CHUNK_BYTES, length - start);
+	MPI_Bcast(buffer.data() + start, chunk, MPI_BYTE, multiprocess::QUEEN_ID, MPI_COMM_WORLD);
+    }
+
+    print_if<VERBOSE>("Queen: broadcast %d tasks in %" PRIu64 " bytes (%zu bytes uncompressed).\n",
+		      count, length, count * sizeof(flat_task));
+}
+
+void communicator::bcast_recv_tasks(task *tasks, int count)
+{
+    uint64_t length = 0;
+    MPI_Bcast(&length, 1, MPI_UNSIGNED_LONG, multiprocess::QUEEN_ID, MPI_COMM_WORLD);
+    std::vector<uint8_t> buffer(length);
+    for (uint64_t start = 0; start < length; start += BROADCAST_CHUNK_BYTES)
+    {
+	int chunk = (int) std::min((uint64_t) BROADCAST_CHUNK_BYTES, length - start);
+	MPI_Bcast(buffer.data() + start, chunk, MPI_BYTE, multiprocess::QUEEN_ID, MPI_COMM_WORLD);
+    }
+
+    deserialize_tasks(buffer.data(), tasks, count);
+}
+
 void communicator::bcast_send_tstatus_transport(int *tstatus_transport, int tstatus_length)
 {
     comm.bcast_send_int_array(multiprocess::QUEEN_ID, tstatus_transport, tstatus_length);
@@ -33,6 +33,9 @@ namespace net
     const int THREAD_RANK = 13;
     const int SENDING_BATCH = 14;
     const int RUNNING_LOW = 15;
+    const int STEAL_REQUEST = 16;
+    const int STEAL_RESPONSE = 17;
+    const int TASK_TIMINGS = 18;
 }
 
 // ----
@@ -55,9 +58,18 @@ class communicator
     int worker_world_size = 0;
     int num_of_workers = 0;
     bool *running_low = NULL;
+    int *requested_batch_size = NULL; // the batch size requested by each overseer when running low
     int* workers_per_overseer = NULL; // number of worker threads for each worker
     int* overseer_map = NULL; // a quick map from workers to overseer
 
+    // The status window of the current round (see rma.hpp).
+    MPI_Win status_window = MPI_WIN_NULL;
+    int *rma_window_memory = nullptr; // only non-empty on the queen
+    int rma_solution_capacity = 0;
+    int rma_pruned_capacity = 0;
+    int rma_solutions_read = 0; // queen: ints of the solution log already collected
+    int rma_pruned_read = 0; // overseer: ids of the pruned log already applied
+
 // Unlike essentially everywhere in the code, here we stick to the principle
 // of hiding the internal functions and exposing only those which need to be
 // implemented.
@@ -73,10 +85,10 @@ private:
     std::pair<int, uint64_t*> bcast_recv_uint64_array(int root_sender);
 
 public:
-    
     void deferred_construction()
 	{
 	    running_low = new bool[multiprocess::world_size];
+	    requested_batch_size = new int[multiprocess::world_size];
 	    workers_per_overseer = new int[multiprocess::world_size];
 
 	    std::string name = gethost();
@@ -93,9 +105,10 @@ public:
 
     ~communicator()
 	{
-	    delete running_low;
-	    delete workers_per_overseer;
-	    delete overseer_map;
+	    delete[] running_low;
+	    delete[] requested_batch_size;
+	    delete[] workers_per_overseer;
+	    delete[] overseer_map;
 	}
 
     void reset_runlows()
@@ -110,6 +123,11 @@ public:
 	{
 	    return running_low[target_overseer];
 	}
+
+    int requested_size(int target_overseer)
+	{
+	    return requested_batch_size[target_overseer];
+	}
     
     void satisfied_runlow(int target_overseer)
 	{
@@ -135,6 +153,8 @@ public:
 
     flat_task bcast_recv_flat_task();
     void bcast_send_flat_task(flat_task& ft);
+    void bcast_send_tasks(const task *tasks, int count);
+    void bcast_recv_tasks(task *tasks, int count);
 
 
 
@@ -154,14 +174,32 @@ public:
     void ignore_additional_signals();
     bool check_root_solved(std::vector<worker_flags*>& w_flags);
     void send_solution_pair(int ftask_id, int solution);
-    void request_new_batch(int _);
-    bool try_receiving_batch(std::array<int, BATCH_SIZE>& upcoming_batch);
+    void send_solutions(const std::vector<int>& solution_pairs);
+    void send_task_timings(const std::vector<int>& timings, int round);
+    int receive_pruned_tasks(std::atomic<task_status> *task_status_array, int round,
+			     std::vector<int> *received_ids = nullptr);
+    void request_new_batch(int requested_size);
+    int try_receiving_batch(std::array<int, MAX_BATCH_SIZE>& upcoming_batch);
+    void send_steal_request(int victim, int round);
+    int check_steal_request(int &round);
+    void send_stolen_tasks(int thief, int round, const std::vector<int>& stolen);
+    int try_receiving_stolen_tasks(int round, std::vector<int>& stolen);
 
     // mpi_qcomm.hpp
-    void send_batch(int *batch, int target_overseer);
+    void send_batch(const std::vector<int>& batch, int target_overseer);
     void collect_runlows();
+    bool collect_solutions(std::vector<int>& solution_pairs);
+    bool collect_task_timings(std::vector<int>& timings, int round);
     void ignore_additional_solutions();
-
+    void send_pruned_tasks(const std::vector<int>& pruned, int round);
+
+    // rma.hpp
+    void rma_open_window(int task_count);
+    void rma_close_window();
+    void rma_store_solutions(const std::vector<int>& solution_pairs);
+    bool rma_collect_solutions(std::vector<int>& solution_pairs);
+    void rma_publish_pruned(const std::vector<int>& pruned, int round);
+    int rma_fetch_pruned(std::atomic<task_status> *task_status_array, int round);
 };
 
 // Currently (MPI is the only option), we store the communicator as a global variable.
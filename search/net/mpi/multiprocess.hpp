@@ -1,7 +1,10 @@
 #pragma once
 #include <cassert>
+#include <vector>
 #include <mpi.h>
 
+#include "../../common.hpp"
+
 // Main start and stop for the processes which oversee the network communication.
 class multiprocess
 {
@@ -21,9 +24,49 @@ public:
     // and world_size (the total size of the network). For local computations, world_size is likely to be 2.
     // The variables are later used in macros such as BEING_QUEEN and BEING_OVERSEER.
 
+    // With SUBQUEEN_FANOUT > 0, the ranks after the queen form groups of one sub-queen
+    // followed by up to SUBQUEEN_FANOUT overseers. A sub-queen stands between the queen
+    // and the overseers of its group (see subqueen.hpp).
+    static bool is_subqueen(int rank)
+	{
+	    return SUBQUEEN_FANOUT > 0 && rank > QUEEN_ID && (rank - 1) % (SUBQUEEN_FANOUT + 1) == 0;
+	}
+
+    // The rank from which an overseer (or a sub-queen) receives its tasks.
+    static int parent(int rank = world_rank)
+	{
+	    if (SUBQUEEN_FANOUT == 0 || is_subqueen(rank))
+	    {
+		return QUEEN_ID;
+	    }
+	    return rank - (rank - 1) % (SUBQUEEN_FANOUT + 1);
+	}
+
+    // The ranks to which the given rank sends tasks, pruned tasks and the root solved signal.
+    static std::vector<int> children(int rank = world_rank)
+	{
+	    std::vector<int> ret;
+	    for (int r = 1; r < world_size; r++)
+	    {
+		if (r != rank && parent(r) == rank)
+		{
+		    ret.push_back(r);
+		}
+	    }
+	    return ret;
+	}
+
     static int overseer_count()
 	{
-	    return multiprocess::world_size - 1;
+	    int count = 0;
+	    for (int r = 1; r < world_size; r++)
+	    {
+		if (!is_subqueen(r))
+		{
+		    count++;
+		}
+	    }
+	    return count;
 	}
     static void init()
 	{
@@ -1,6 +1,8 @@
 #ifndef _NET_MPI_OCOMM_HPP
 #define _NET_MPI_OCOMM_HPP 1
 
+// MPI networking methods used by the overseers. An overseer talks to its parent, which is
+// the queen or, with SUBQUEEN_FANOUT > 0, the sub-queen of its group.
 
 // Workers fetch and ignore additional signals about root solved (since it may arrive in two places).
 void communicator::ignore_additional_signals()
@@ -8,29 +10,47 @@ void communicator::ignore_additional_signals()
     MPI_Status stat;
     int signal_present = 0;
     int irrel = 0 ;
-    MPI_Iprobe(multiprocess::QUEEN_ID, net::SENDING_TASK, MPI_COMM_WORLD, &signal_present, &stat);
+    MPI_Iprobe(multiprocess::parent(), net::SENDING_TASK, MPI_COMM_WORLD, &signal_present, &stat);
     while (signal_present)
     {
 	signal_present = 0;
-	MPI_Recv(&irrel, 1, MPI_INT, multiprocess::QUEEN_ID, net::SENDING_TASK, MPI_COMM_WORLD, &stat);
-	MPI_Iprobe(multiprocess::QUEEN_ID, net::SENDING_TASK, MPI_COMM_WORLD, &signal_present, &stat);
+	MPI_Recv(&irrel, 1, MPI_INT, multiprocess::parent(), net::SENDING_TASK, MPI_COMM_WORLD, &stat);
+	MPI_Iprobe(multiprocess::parent(), net::SENDING_TASK, MPI_COMM_WORLD, &signal_present, &stat);
     }
 
-    MPI_Iprobe(multiprocess::QUEEN_ID, net::SENDING_IRRELEVANT, MPI_COMM_WORLD, &signal_present, &stat);
+    MPI_Iprobe(multiprocess::parent(), net::SENDING_IRRELEVANT, MPI_COMM_WORLD, &signal_present, &stat);
     while (signal_present)
     {
 	signal_present = 0;
-	MPI_Recv(&irrel, 1, MPI_INT, multiprocess::QUEEN_ID, net::SENDING_IRRELEVANT, MPI_COMM_WORLD, &stat);
-	MPI_Iprobe(multiprocess::QUEEN_ID, net::SENDING_IRRELEVANT, MPI_COMM_WORLD, &signal_present, &stat);
+	int irrel_pruned[PRUNED_BATCH_SIZE+1];
+	MPI_Recv(irrel_pruned, PRUNED_BATCH_SIZE+1, MPI_INT, multiprocess::parent(), net::SENDING_IRRELEVANT, MPI_COMM_WORLD, &stat);
+	MPI_Iprobe(multiprocess::parent(), net::SENDING_IRRELEVANT, MPI_COMM_WORLD, &signal_present, &stat);
+    }
+
+    // Steal requests and responses are tagged by the round number, so any stale ones
+    // which arrive later are recognized; we still clean up what we can.
+    MPI_Iprobe(MPI_ANY_SOURCE, net::STEAL_REQUEST, MPI_COMM_WORLD, &signal_present, &stat);
+    while (signal_present)
+    {
+	MPI_Recv(&irrel, 1, MPI_INT, stat.MPI_SOURCE, net::STEAL_REQUEST, MPI_COMM_WORLD, &stat);
+	MPI_Iprobe(MPI_ANY_SOURCE, net::STEAL_REQUEST, MPI_COMM_WORLD, &signal_present, &stat);
+    }
+
+    MPI_Iprobe(MPI_ANY_SOURCE, net::STEAL_RESPONSE, MPI_COMM_WORLD, &signal_present, &stat);
+    while (signal_present)
+    {
+	int irrel_stolen[MAX_BATCH_SIZE+1];
+	MPI_Recv(irrel_stolen, MAX_BATCH_SIZE+1, MPI_INT, stat.MPI_SOURCE, net::STEAL_RESPONSE, MPI_COMM_WORLD, &stat);
+	MPI_Iprobe(MPI_ANY_SOURCE, net::STEAL_RESPONSE, MPI_COMM_WORLD, &signal_present, &stat);
     }
 
     // ignore any incoming batches
-    MPI_Iprobe(multiprocess::QUEEN_ID, net::SENDING_BATCH, MPI_COMM_WORLD, &signal_present, &stat);
+    MPI_Iprobe(multiprocess::parent(), net::SENDING_BATCH, MPI_COMM_WORLD, &signal_present, &stat);
     while (signal_present)
     {
-	int irrel_batch[BATCH_SIZE];
-	MPI_Recv(irrel_batch, BATCH_SIZE, MPI_INT, multiprocess::QUEEN_ID, net::SENDING_BATCH, MPI_COMM_WORLD, &stat);
-	MPI_Iprobe(multiprocess::QUEEN_ID, net::SENDING_BATCH, MPI_COMM_WORLD, &signal_present, &stat);
+	int irrel_batch[MAX_BATCH_SIZE];
+	MPI_Recv(irrel_batch, MAX_BATCH_SIZE, MPI_INT, multiprocess::parent(), net::SENDING_BATCH, MPI_COMM_WORLD, &stat);
+	MPI_Iprobe(multiprocess::parent(), net::SENDING_BATCH, MPI_COMM_WORLD, &signal_present, &stat);
     }
  
 }
@@ -39,11 +59,11 @@ bool communicator::check_root_solved(std::vector<worker_flags*>& w_flags)
 {
     MPI_Status stat;
     int root_solved_flag = 0;
-    MPI_Iprobe(multiprocess::QUEEN_ID, net::ROOT_SOLVED, MPI_COMM_WORLD, &root_solved_flag, &stat);
+    MPI_Iprobe(multiprocess::parent(), net::ROOT_SOLVED, MPI_COMM_WORLD, &root_solved_flag, &stat);
     if (root_solved_flag)
     {
 	int r_s = ROOT_UNSOLVED_SIGNAL;
-	MPI_Recv(&r_s, 1, MPI_INT, multiprocess::QUEEN_ID, net::ROOT_SOLVED, MPI_COMM_WORLD, &stat);
+	MPI_Recv(&r_s, 1, MPI_INT, multiprocess::parent(), net::ROOT_SOLVED, MPI_COMM_WORLD, &stat);
 	if (r_s == ROOT_SOLVED_SIGNAL)
 	{
 	    for(unsigned int i = 0; i < w_flags.size(); i++)
@@ -60,16 +80,124 @@ void communicator::send_solution_pair(int ftask_id, int solution)
 {
     int solution_pair[2] = {ftask_id, solution};
     // solution_pair[0] = ftask_id; solution_pair[1] = solution;
-    MPI_Send(&solution_pair, 2, MPI_INT, multiprocess::QUEEN_ID, net::SOLUTION, MPI_COMM_WORLD);
+    MPI_Send(&solution_pair, 2, MPI_INT, multiprocess::parent(), net::SOLUTION, MPI_COMM_WORLD);
+}
+
+// Sends (task id, status) pairs, stored consecutively, in one message.
+void communicator::send_solutions(const std::vector<int>& solution_pairs)
+{
+    assert(solution_pairs.size() % 2 == 0 && solution_pairs.size() <= 2*SOLUTION_BATCH_SIZE);
+    MPI_Send(solution_pairs.data(), solution_pairs.size(), MPI_INT, multiprocess::parent(), net::SOLUTION, MPI_COMM_WORLD);
+}
+
+// Sends (task id, milliseconds) pairs of solved tasks, at most as many as solutions in one message.
+// The message starts with the round number, as the task ids are only valid within the round.
+void communicator::send_task_timings(const std::vector<int>& timings, int round)
+{
+    assert(timings.size() % 2 == 0 && timings.size() <= 2*SOLUTION_BATCH_SIZE);
+    std::vector<int> message(1, round);
+    message.insert(message.end(), timings.begin(), timings.end());
+    MPI_Send(message.data(), message.size(), MPI_INT, multiprocess::parent(), net::TASK_TIMINGS, MPI_COMM_WORLD);
 }
 
-void communicator::request_new_batch(int _)
+// Marks the tasks which the queen reports as pruned, unless they are already solved.
+// Messages of an earlier round are dropped. Returns the number of ids received.
+// If received_ids is given, the ids are also appended to it (a sub-queen passes them on).
+int communicator::receive_pruned_tasks(std::atomic<task_status> *task_status_array, int round,
+				       std::vector<int> *received_ids)
 {
-    int irrel = 0;
-    MPI_Send(&irrel, 1, MPI_INT, multiprocess::QUEEN_ID, net::RUNNING_LOW, MPI_COMM_WORLD);
+    int pruned_count = 0;
+    int pruned_present = 0;
+    MPI_Status stat;
+    MPI_Iprobe(multiprocess::parent(), net::SENDING_IRRELEVANT, MPI_COMM_WORLD, &pruned_present, &stat);
+    while (pruned_present)
+    {
+	std::array<int, PRUNED_BATCH_SIZE+1> pruned;
+	int received = 0;
+	MPI_Recv(pruned.data(), PRUNED_BATCH_SIZE+1, MPI_INT, multiprocess::parent(), net::SENDING_IRRELEVANT, MPI_COMM_WORLD, &stat);
+	MPI_Get_count(&stat, MPI_INT, &received);
+	if (received >= 1 && pruned[0] == round)
+	{
+	    for (int i = 1; i < received; i++)
+	    {
+		task_status expected = task_status::available;
+		task_status_array[pruned[i]].compare_exchange_strong(expected, task_status::pruned);
+	    }
+	    if (received_ids != nullptr)
+	    {
+		received_ids->insert(received_ids->end(), pruned.begin() + 1, pruned.begin() + received);
+	    }
+	    pruned_count += received - 1;
+	}
+	MPI_Iprobe(multiprocess::parent(), net::SENDING_IRRELEVANT, MPI_COMM_WORLD, &pruned_present, &stat);
+    }
+
+    return pruned_count;
+}
+
+void communicator::request_new_batch(int requested_size)
+{
+    MPI_Send(&requested_size, 1, MPI_INT, multiprocess::parent(), net::RUNNING_LOW, MPI_COMM_WORLD);
+}
+
+// Work stealing between overseers.
+
+void communicator::send_steal_request(int victim, int round)
+{
+    MPI_Send(&round, 1, MPI_INT, victim, net::STEAL_REQUEST, MPI_COMM_WORLD);
+}
+
+// Returns the rank of an overseer asking for tasks (and its round), or -1 if there is none.
+int communicator::check_steal_request(int &round)
+{
+    int request_present = 0;
+    MPI_Status stat;
+    MPI_Iprobe(MPI_ANY_SOURCE, net::STEAL_REQUEST, MPI_COMM_WORLD, &request_present, &stat);
+    if (!request_present)
+    {
+	return -1;
+    }
+
+    MPI_Recv(&round, 1, MPI_INT, stat.MPI_SOURCE, net::STEAL_REQUEST, MPI_COMM_WORLD, &stat);
+    return stat.MPI_SOURCE;
+}
+
+// The response is the round number followed by the task ids, possibly none.
+void communicator::send_stolen_tasks(int thief, int round, const std::vector<int>& stolen)
+{
+    assert(stolen.size() <= MAX_BATCH_SIZE);
+    std::vector<int> message(1, round);
+    message.insert(message.end(), stolen.begin(), stolen.end());
+    MPI_Send(message.data(), message.size(), MPI_INT, thief, net::STEAL_RESPONSE, MPI_COMM_WORLD);
+}
+
+// Returns -1 if no response of the current round arrived, otherwise the number of stolen tasks.
+int communicator::try_receiving_stolen_tasks(int round, std::vector<int>& stolen)
+{
+    int response_present = 0;
+    MPI_Status stat;
+    MPI_Iprobe(MPI_ANY_SOURCE, net::STEAL_RESPONSE, MPI_COMM_WORLD, &response_present, &stat);
+    while (response_present)
+    {
+	std::array<int, MAX_BATCH_SIZE+1> message;
+	int received = 0;
+	MPI_Recv(message.data(), MAX_BATCH_SIZE+1, MPI_INT, stat.MPI_SOURCE, net::STEAL_RESPONSE, MPI_COMM_WORLD, &stat);
+	MPI_Get_count(&stat, MPI_INT, &received);
+	if (received >= 1 && message[0] == round)
+	{
+	    stolen.assign(message.begin() + 1, message.begin() + received);
+	    return received - 1;
+	}
+
+	// A stale response from an earlier round.
+	MPI_Iprobe(MPI_ANY_SOURCE, net::STEAL_RESPONSE, MPI_COMM_WORLD, &response_present, &stat);
+    }
+
+    return -1;
 }
 
-bool communicator::try_receiving_batch(std::array<int, BATCH_SIZE>& upcoming_batch)
+// Returns the number of tasks received, zero if no batch arrived.
+int communicator::try_receiving_batch(std::array<int, MAX_BATCH_SIZE>& upcoming_batch)
 {
     print_if<TASK_DEBUG>("Overseer %d: Attempting to receive a new batch. \n",
 		      multiprocess::world_rank);
@@ -77,15 +205,17 @@ bool communicator::try_receiving_batch(std::array<int, BATCH_SIZE>& upcoming_bat
 
     int batch_incoming = 0;
     MPI_Status stat;
-    MPI_Iprobe(multiprocess::QUEEN_ID, net::SENDING_BATCH, MPI_COMM_WORLD, &batch_incoming, &stat);
+    MPI_Iprobe(multiprocess::parent(), net::SENDING_BATCH, MPI_COMM_WORLD, &batch_incoming, &stat);
     if (batch_incoming)
     {
 	print_if<COMM_DEBUG>("Overseer %d receives the new batch.\n", multiprocess::world_rank);
-	MPI_Recv(upcoming_batch.data(), BATCH_SIZE, MPI_INT, multiprocess::QUEEN_ID, net::SENDING_BATCH, MPI_COMM_WORLD, &stat);
-	return true;
+	MPI_Recv(upcoming_batch.data(), MAX_BATCH_SIZE, MPI_INT, multiprocess::parent(), net::SENDING_BATCH, MPI_COMM_WORLD, &stat);
+	int received = 0;
+	MPI_Get_count(&stat, MPI_INT, &received);
+	return received;
     } else
     {
-	return false;
+	return 0;
     }
 }
 
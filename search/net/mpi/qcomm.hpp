@@ -6,9 +6,10 @@
 // but the assumption is that they are quite similar from the point of the queen
 // and overseers.
 
-void communicator::send_batch(int *batch, int target_overseer)
+void communicator::send_batch(const std::vector<int>& batch, int target_overseer)
 {
-    MPI_Send(batch, BATCH_SIZE, MPI_INT, target_overseer, net::SENDING_BATCH, MPI_COMM_WORLD);
+    assert(batch.size() <= MAX_BATCH_SIZE);
+    MPI_Send(batch.data(), batch.size(), MPI_INT, target_overseer, net::SENDING_BATCH, MPI_COMM_WORLD);
 }
 
 
@@ -16,31 +17,49 @@ void communicator::collect_runlows()
 {
     int running_low_received = 0;
     MPI_Status stat;
-    int irrel;
+    int requested = 0;
     MPI_Iprobe(MPI_ANY_SOURCE, net::RUNNING_LOW, MPI_COMM_WORLD, &running_low_received, &stat);
     while(running_low_received)
     {
 	running_low_received = 0;
 	int sender = stat.MPI_SOURCE;
-	MPI_Recv(&irrel, 1, MPI_INT, sender, net::RUNNING_LOW, MPI_COMM_WORLD, &stat);
+	MPI_Recv(&requested, 1, MPI_INT, sender, net::RUNNING_LOW, MPI_COMM_WORLD, &stat);
 	running_low[sender] = true;
+	requested_batch_size[sender] = requested;
 	MPI_Iprobe(MPI_ANY_SOURCE, net::RUNNING_LOW, MPI_COMM_WORLD, &running_low_received, &stat);
     }
 }
 
 
+// Sends the ids of pruned tasks to all children, in messages of at most PRUNED_BATCH_SIZE ids.
+// Each message starts with the round number, so that the overseers can drop late messages.
+void communicator::send_pruned_tasks(const std::vector<int>& pruned, int round)
+{
+    std::vector<int> message;
+    for (uint64_t start = 0; start < pruned.size(); start += PRUNED_BATCH_SIZE)
+    {
+	uint64_t end = std::min(start + PRUNED_BATCH_SIZE, (uint64_t) pruned.size());
+	message.assign(1, round);
+	message.insert(message.end(), pruned.begin() + start, pruned.begin() + end);
+	for (int child : multiprocess::children())
+	{
+	    MPI_Send(message.data(), message.size(), MPI_INT, child, net::SENDING_IRRELEVANT, MPI_COMM_WORLD);
+	}
+    }
+}
+
 // Queen fetches and ignores the remaining tasks from the previous iteration.
 void communicator::ignore_additional_solutions()
 {
     int solution_received = 0;
-    int solution_pair[2] = {0,0};
+    std::array<int, 2*SOLUTION_BATCH_SIZE> solution_pairs;
     MPI_Status stat;
     MPI_Iprobe(MPI_ANY_SOURCE, net::SOLUTION, MPI_COMM_WORLD, &solution_received, &stat);
     while(solution_received)
     {
 	solution_received = 0;
 	int sender = stat.MPI_SOURCE;
-	MPI_Recv(solution_pair, 2, MPI_INT, sender, net::SOLUTION, MPI_COMM_WORLD, &stat);
+	MPI_Recv(solution_pairs.data(), 2*SOLUTION_BATCH_SIZE, MPI_INT, sender, net::SOLUTION, MPI_COMM_WORLD, &stat);
 	MPI_Iprobe(MPI_ANY_SOURCE, net::SOLUTION, MPI_COMM_WORLD, &solution_received, &stat);
     }
     
@@ -56,10 +75,12 @@ void communicator::ignore_additional_solutions()
     }
 }
 
-void collect_worker_tasks()
+// Appends all (task id, status) pairs received so far. Returns false if there were none.
+bool communicator::collect_solutions(std::vector<int>& solution_pairs)
 {
+    bool collected = false;
     int solution_received = 0;
-    int solution_pair[2] = {0,0};
+    std::array<int, 2*SOLUTION_BATCH_SIZE> message;
     MPI_Status stat;
 
     MPI_Iprobe(MPI_ANY_SOURCE, net::SOLUTION, MPI_COMM_WORLD, &solution_received, &stat);
@@ -67,24 +88,63 @@ void collect_worker_tasks()
     {
 	solution_received = 0;
 	int sender = stat.MPI_SOURCE;
-	MPI_Recv(solution_pair, 2, MPI_INT, sender, net::SOLUTION, MPI_COMM_WORLD, &stat);
-	qmemory::collected_now++;
-	qmemory::collected_cumulative++;
-	//printf("Queen: received solution %d.\n", solution);
-        // add it to the collected set of the queen
-	if (static_cast<task_status>(solution_pair[1]) != task_status::irrelevant)
+	int received = 0;
+	MPI_Recv(message.data(), 2*SOLUTION_BATCH_SIZE, MPI_INT, sender, net::SOLUTION, MPI_COMM_WORLD, &stat);
+	MPI_Get_count(&stat, MPI_INT, &received);
+	solution_pairs.insert(solution_pairs.end(), message.begin(), message.begin() + received);
+	collected = true;
+	MPI_Iprobe(MPI_ANY_SOURCE, net::SOLUTION, MPI_COMM_WORLD, &solution_received, &stat);
+    }
+    return collected;
+}
+
+// Appends all (task id, milliseconds) pairs of the given round received so far; messages
+// of an earlier round are dropped. Returns false if there were no pairs of the round.
+bool communicator::collect_task_timings(std::vector<int>& timings, int round)
+{
+    bool collected = false;
+    int timings_received = 0;
+    std::array<int, 2*SOLUTION_BATCH_SIZE+1> message;
+    MPI_Status stat;
+
+    MPI_Iprobe(MPI_ANY_SOURCE, net::TASK_TIMINGS, MPI_COMM_WORLD, &timings_received, &stat);
+    while(timings_received)
+    {
+	timings_received = 0;
+	int sender = stat.MPI_SOURCE;
+	int received = 0;
+	MPI_Recv(message.data(), 2*SOLUTION_BATCH_SIZE+1, MPI_INT, sender, net::TASK_TIMINGS, MPI_COMM_WORLD, &stat);
+	MPI_Get_count(&stat, MPI_INT, &received);
+	if (received > 1 && message[0] == round)
 	{
-	    if (tstatus[solution_pair[0]].load(std::memory_order_acquire) == task_status::pruned)
-	    {
-		g_meas.pruned_collision++;
-	    }
-	    tstatus[solution_pair[0]].store(static_cast<task_status>(solution_pair[1]),
-					    std::memory_order_release);
-	    // transmit the solution_pair[0] as solved
-	    // transmit_irrelevant_task(solution_pair[0]);
+	    timings.insert(timings.end(), message.begin() + 1, message.begin() + received);
+	    collected = true;
 	}
-	
-	MPI_Iprobe(MPI_ANY_SOURCE, net::SOLUTION, MPI_COMM_WORLD, &solution_received, &stat);
+	MPI_Iprobe(MPI_ANY_SOURCE, net::TASK_TIMINGS, MPI_COMM_WORLD, &timings_received, &stat);
+    }
+    return collected;
+}
+
+// Each message holds one or more (task id, status) pairs.
+// With USING_RMA_TSTATUS, the pairs are read from the status window, and messages
+// are only probed for if some overseer could not fit into the window.
+void collect_worker_tasks()
+{
+    if (USING_RMA_TSTATUS)
+    {
+	std::vector<int> rma_pairs;
+	bool overflow = comm.rma_collect_solutions(rma_pairs);
+	apply_solution_pairs(rma_pairs.data(), rma_pairs.size());
+	if (!overflow)
+	{
+	    return;
+	}
+    }
+
+    std::vector<int> solution_pairs;
+    if (comm.collect_solutions(solution_pairs))
+    {
+	apply_solution_pairs(solution_pairs.data(), solution_pairs.size());
     }
 }
 #endif
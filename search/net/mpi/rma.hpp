@@ -0,0 +1,183 @@
+#ifndef _NET_MPI_RMA_HPP
+#define _NET_MPI_RMA_HPP 1
+
+// One-sided (RMA) transport of task statuses, used instead of the SOLUTION and
+// SENDING_IRRELEVANT messages when USING_RMA_TSTATUS is set.
+
+// For each round, the queen hosts a window holding two append-only logs:
+// the solution log, into which the overseers write (task id, status) pairs,
+// and the pruned log, into which the queen writes the ids of pruned tasks.
+// The overseers access the window with passive-target synchronization only,
+// so the queen never has to probe for incoming solutions; it reads its own
+// memory under an exclusive lock whenever it is convenient.
+
+// An overseer reserves space in the solution log by an atomic MPI_Fetch_and_op on
+// the head of the log and fills it by MPI_Accumulate in the same access epoch.
+// Since the queen reads under an exclusive lock, it never sees a reserved but
+// unwritten slot. If a log is full, the sender falls back to messages and raises
+// an overflow counter, so that the receiver knows it has to probe for them.
+
+// Layout of the window, in ints.
+namespace rma
+{
+    const int SOLUTION_HEAD = 0; // Number of ints reserved in the solution log.
+    const int PRUNED_COUNT = 1; // Number of ids written into the pruned log.
+    const int SOLUTION_OVERFLOW = 2; // Number of solution messages sent instead.
+    const int PRUNED_OVERFLOW = 3; // Number of pruned messages sent instead.
+    const int HEADER = 4;
+}
+
+// Collective; called by the queen and all overseers once tcount is known.
+void communicator::rma_open_window(int task_count)
+{
+    // Normally, every task enters each log at most once per round;
+    // the fallback to messages covers the rest.
+    rma_solution_capacity = 2*task_count;
+    rma_pruned_capacity = task_count;
+    rma_solutions_read = 0;
+    rma_pruned_read = 0;
+
+    MPI_Aint window_size = 0;
+    if (multiprocess::world_rank == multiprocess::QUEEN_ID)
+    {
+	window_size = (rma::HEADER + rma_solution_capacity + rma_pruned_capacity) * sizeof(int);
+    }
+
+    MPI_Win_allocate(window_size, sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD, &rma_window_memory, &status_window);
+
+    if (multiprocess::world_rank == multiprocess::QUEEN_ID)
+    {
+	MPI_Win_lock(MPI_LOCK_EXCLUSIVE, multiprocess::QUEEN_ID, 0, status_window);
+	for (int i = 0; i < rma::HEADER; i++)
+	{
+	    rma_window_memory[i] = 0;
+	}
+	for (int i = 0; i < rma_solution_capacity; i++)
+	{
+	    rma_window_memory[rma::HEADER + i] = -1;
+	}
+	MPI_Win_unlock(multiprocess::QUEEN_ID, status_window);
+    }
+
+    // No overseer may write into the window before it is initialized.
+    sync_up();
+}
+
+// Collective; called at the end of the round, when no access epoch is open.
+void communicator::rma_close_window()
+{
+    MPI_Win_free(&status_window);
+    rma_window_memory = nullptr;
+}
+
+// Overseer: writes (task id, status) pairs into the solution log of the queen.
+void communicator::rma_store_solutions(const std::vector<int>& solution_pairs)
+{
+    assert(solution_pairs.size() % 2 == 0 && solution_pairs.size() <= 2*SOLUTION_BATCH_SIZE);
+    int size = solution_pairs.size();
+    int start = 0;
+
+    MPI_Win_lock(MPI_LOCK_SHARED, multiprocess::QUEEN_ID, 0, status_window);
+    MPI_Fetch_and_op(&size, &start, MPI_INT, multiprocess::QUEEN_ID, rma::SOLUTION_HEAD, MPI_SUM, status_window);
+    MPI_Win_flush(multiprocess::QUEEN_ID, status_window);
+
+    bool fits = start + size <= rma_solution_capacity;
+    if (fits)
+    {
+	MPI_Accumulate(solution_pairs.data(), size, MPI_INT, multiprocess::QUEEN_ID,
+		       rma::HEADER + start, size, MPI_INT, MPI_REPLACE, status_window);
+    } else
+    {
+	int one = 1;
+	MPI_Accumulate(&one, 1, MPI_INT, multiprocess::QUEEN_ID, rma::SOLUTION_OVERFLOW,
+		       1, MPI_INT, MPI_SUM, status_window);
+    }
+    MPI_Win_unlock(multiprocess::QUEEN_ID, status_window);
+
+    if (!fits)
+    {
+	send_solutions(solution_pairs);
+    }
+}
+
+// Queen: appends the unread part of the solution log to solution_pairs.
+// Returns true if some overseer had to send its solutions as messages instead
+// in this round, in which case the queen also has to probe for them.
+bool communicator::rma_collect_solutions(std::vector<int>& solution_pairs)
+{
+    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, multiprocess::QUEEN_ID, 0, status_window);
+    int head = std::min(rma_window_memory[rma::SOLUTION_HEAD], rma_solution_capacity);
+    for (int i = rma_solutions_read; i + 1 < head; i += 2)
+    {
+	// Slots reserved by a sender which then did not fit remain empty.
+	if (rma_window_memory[rma::HEADER + i] >= 0)
+	{
+	    solution_pairs.push_back(rma_window_memory[rma::HEADER + i]);
+	    solution_pairs.push_back(rma_window_memory[rma::HEADER + i + 1]);
+	}
+    }
+    rma_solutions_read = std::max(rma_solutions_read, head);
+    int overflows = rma_window_memory[rma::SOLUTION_OVERFLOW];
+    MPI_Win_unlock(multiprocess::QUEEN_ID, status_window);
+
+    return overflows > 0;
+}
+
+// Queen: appends ids of pruned tasks to the pruned log.
+void communicator::rma_publish_pruned(const std::vector<int>& pruned, int round)
+{
+    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, multiprocess::QUEEN_ID, 0, status_window);
+    int count = rma_window_memory[rma::PRUNED_COUNT];
+    bool fits = count + (int) pruned.size() <= rma_pruned_capacity;
+    if (fits)
+    {
+	int *log = rma_window_memory + rma::HEADER + rma_solution_capacity;
+	std::copy(pruned.begin(), pruned.end(), log + count);
+	rma_window_memory[rma::PRUNED_COUNT] = count + pruned.size();
+    } else
+    {
+	rma_window_memory[rma::PRUNED_OVERFLOW]++;
+    }
+    MPI_Win_unlock(multiprocess::QUEEN_ID, status_window);
+
+    if (!fits)
+    {
+	send_pruned_tasks(pruned, round);
+    }
+}
+
+// Overseer: fetches the ids pruned since the last call and marks them as pruned,
+// unless they are already solved. Returns the number of ids fetched.
+int communicator::rma_fetch_pruned(std::atomic<task_status> *task_status_array, int round)
+{
+    std::array<int, rma::HEADER> header;
+    std::vector<int> pruned;
+
+    MPI_Win_lock(MPI_LOCK_SHARED, multiprocess::QUEEN_ID, 0, status_window);
+    MPI_Get(header.data(), rma::HEADER, MPI_INT, multiprocess::QUEEN_ID, 0, rma::HEADER, MPI_INT, status_window);
+    MPI_Win_flush(multiprocess::QUEEN_ID, status_window);
+    int fresh = header[rma::PRUNED_COUNT] - rma_pruned_read;
+    if (fresh > 0)
+    {
+	pruned.resize(fresh);
+	MPI_Get(pruned.data(), fresh, MPI_INT, multiprocess::QUEEN_ID,
+		rma::HEADER + rma_solution_capacity + rma_pruned_read, fresh, MPI_INT, status_window);
+    }
+    MPI_Win_unlock(multiprocess::QUEEN_ID, status_window);
+    rma_pruned_read += std::max(fresh, 0);
+
+    for (int id : pruned)
+    {
+	task_status expected = task_status::available;
+	task_status_array[id].compare_exchange_strong(expected, task_status::pruned);
+    }
+
+    int ret = pruned.size();
+    if (header[rma::PRUNED_OVERFLOW] > 0)
+    {
+	ret += receive_pruned_tasks(task_status_array, round);
+    }
+    return ret;
+}
+
+#endif
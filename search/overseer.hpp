@@ -7,6 +7,8 @@
 #include "tasks.hpp"
 #include "server_properties.hpp"
 #include "worker.hpp"
+#include "wakeup.hpp"
+#include "mpmc_queue.hpp"
 
 class overseer
 {
@@ -14,22 +16,51 @@ public:
 
     std::vector<worker*> wrkr; // array of worker pointers.
     std::vector<worker_flags*> w_flags; // array of overseer-worker communication flags.
-    std::array<int, BATCH_SIZE> upcoming_batch;
+    std::array<int, MAX_BATCH_SIZE> upcoming_batch;
 
-    // A list of tasks assigned to an overseer.
-    std::vector<int> tasks;
-    // A semiatomic queue of finished tasks.
-    semiatomic_q* finished_tasks;
+    // Adaptive batching: the batch size this overseer asks for, updated from the measured
+    // rate at which the workers take tasks.
+    int batch_request_size = BATCH_SIZE;
+    double task_rate = 0.0; // tasks per second, smoothed
+    unsigned int tasks_taken_at_request = 0;
+    std::chrono::time_point<std::chrono::steady_clock> last_request_time;
+
+    // Solutions waiting to be sent to the queen, as (task id, status) pairs.
+    std::vector<int> pending_solutions;
+    // The processing times of the solved tasks, written by the workers, and those waiting
+    // to be sent to the queen, as (task id, milliseconds) pairs (see task_cost.hpp).
+    std::vector<int> task_milliseconds;
+    std::vector<int> pending_timings;
+    std::chrono::time_point<std::chrono::steady_clock> oldest_pending_solution;
+
+    // The number of rounds started so far, the same as on the queen. Pruning and steal
+    // messages carry it, so that late messages from a previous round can be recognized.
+    int round = 0;
+    // Work stealing.
+    bool queue_drained = false; // The queen has no more tasks for this overseer.
+    bool steal_requested = false;
+    int steal_victim = 0;
+    int empty_steal_responses = 0;
+
+    // Tasks assigned to an overseer and not yet taken by a worker. The overseer pushes
+    // the batches, the workers pop the tasks without any lock.
+    mpmc_queue<int> tasks;
+    // Tasks solved by the workers, to be reported by the overseer.
+    mpmc_queue<int> finished_tasks;
 
     WEIGHT_HEURISTICS* weight_heurs = nullptr;
     minibs<MINIBS_SCALE_WORKER>* mbs = nullptr;
 
-    // An index to the overseer tasklist that shows the next available task.
-    // Will be accessed concurrently.
-    std::atomic<unsigned int> next_task;
+    // The number of tasks appended in this round; only accessed by the overseer thread.
+    unsigned int tasks_appended = 0;
     
     std::atomic<bool> final_round;
 
+    // Signalled by the overseer when new tasks arrive or the root is solved.
+    wakeup_event task_event;
+    // Signalled by the workers when they take or finish a task or go to sleep.
+    wakeup_event overseer_event;
+
     // measure_attr collected_meas;
 
     overseer() {};
@@ -39,10 +70,26 @@ public:
     void sleep_until_all_workers_waiting();
     void sleep_until_all_workers_ready();
     void process_finished_tasks();
+    void flush_solutions();
+
+    void update_batch_request_size();
+    void append_tasks(const int *begin, const int *end);
+    std::vector<int> claim_unstarted_tasks();
+    void answer_steal_requests();
+    void steal_if_idle();
+
+    // Every worker should get at least a couple of tasks from a batch.
+    int smallest_batch_request()
+    {
+	return std::min(MAX_BATCH_SIZE, std::max(MIN_BATCH_SIZE, 2*worker_count));
+    }
 
+    // We ask for the next batch while half of the current batch is still unprocessed,
+    // so that the next batch arrives before the workers run out of tasks.
     bool running_low()
     {
-	return tasks.size() <= next_task.load() + BATCH_THRESHOLD;
+	unsigned int threshold = std::max(worker_count, batch_request_size / 2);
+	return tasks.size() <= threshold;
     }
 
 };
@@ -12,12 +12,17 @@
 void overseer::cleanup()
     {
 	assert(tarray != NULL && tstatus != NULL);
-	destroy_tarray();
-	destroy_tstatus();
+	// In the local mode, the arrays belong to the queen.
+	if (!LOCAL_COMMUNICATOR)
+	{
+	    destroy_tarray();
+	    destroy_tstatus();
+	}
 	tasks.clear();
-	next_task.store(0);
-	
-	for (int p = 0; p < worker_count; p++) { finished_tasks[p].clear(); }
+	tasks_appended = 0;
+	pending_solutions.clear();
+	pending_timings.clear();
+	finished_tasks.clear();
 	comm.ignore_additional_signals();
 
 	// root_solved.store(false);
@@ -45,28 +50,30 @@ bool overseer::all_workers_waiting()
     return true;
 }
 
-// Actively polls until all workers are waiting.
+// Sleeps until all workers are waiting. The workers signal each change of their state.
 void overseer::sleep_until_all_workers_waiting()
 {
     print_if<COMM_DEBUG>("Overseer %d sleeping until all workers are waiting.\n", multiprocess::world_rank);
     while (true)
     {
+	uint64_t worker_epoch = overseer_event.epoch();
 	if (all_workers_waiting())
 	{
 	    break;
 	}
-	std::this_thread::sleep_for(std::chrono::milliseconds(TICK_SLEEP));
+	overseer_event.wait_since(worker_epoch);
     }
     print_if<COMM_DEBUG>("Overseer %d wakes up.\n", multiprocess::world_rank);
 }
 
-// Actively polls until all workers are ready.
+// Sleeps until all workers are ready.
 void overseer::sleep_until_all_workers_ready()
 {
     print_if<COMM_DEBUG>("Overseer %d sleeping until all workers are ready.\n", multiprocess::world_rank);
     
     while (true)
     {
+	uint64_t worker_epoch = overseer_event.epoch();
 	bool all_ready = true;
 	
 	for (worker* w : wrkr)
@@ -82,37 +89,234 @@ void overseer::sleep_until_all_workers_ready()
 	{
 	    break;  
 	} else {
-		std::this_thread::sleep_for(std::chrono::milliseconds(TICK_SLEEP));
+	    overseer_event.wait_since(worker_epoch);
 	}
     }
     print_if<COMM_DEBUG>("Overseer %d wakes up.\n", multiprocess::world_rank);
     
 }
 
-void overseer::process_finished_tasks()
+// Sets the size of the next requested batch to about BATCH_TARGET_SECONDS worth of tasks,
+// based on the rate of taking tasks since the last request.
+void overseer::update_batch_request_size()
 {
-    for (int p = 0; p < worker_count; p++)
+    auto now = std::chrono::steady_clock::now();
+    unsigned int taken = tasks_appended - std::min((unsigned int) tasks.size(), tasks_appended);
+    std::chrono::duration<double> elapsed = now - last_request_time;
+
+    if (taken > tasks_taken_at_request && elapsed.count() > 0)
     {
-	int ftask_id = finished_tasks[p].pop_if_able();
-	if (ftask_id == -1)
+	double current_rate = (taken - tasks_taken_at_request) / elapsed.count();
+	task_rate = (task_rate == 0.0) ? current_rate : (task_rate + current_rate) / 2;
+	int target = (int) (task_rate * BATCH_TARGET_SECONDS);
+	batch_request_size = std::clamp(target, smallest_batch_request(), MAX_BATCH_SIZE);
+    }
+
+    tasks_taken_at_request = taken;
+    last_request_time = now;
+}
+
+// Appends tasks to the overseer's queue. With work stealing, the end-of-queue markers
+// are filtered out, so that the workers keep waiting for tasks stolen later.
+
+// After the first marker, the queen has nothing more to send in this round, so no further
+// batch is requested. A task is in at most one queue at a time, so the queue never holds
+// more than tcount tasks and one batch of markers.
+void overseer::append_tasks(const int *begin, const int *end)
+{
+    for (const int *t = begin; t != end; t++)
+    {
+	if (*t == NO_MORE_TASKS)
 	{
-	    //print_if<true>("Queue empty for worker %d.\n", p);
+	    queue_drained = true;
+	    if (USING_WORK_STEALING)
+	    {
+		continue;
+	    }
 	}
-	
-	while (ftask_id != -1)
+
+	bool pushed = tasks.push(*t);
+	assert(pushed);
+	tasks_appended++;
+    }
+
+    task_event.notify();
+}
+
+// Claims up to half of the unstarted tasks for another overseer. The tasks are popped
+// from the queue exactly as a worker would take them, so no task is taken twice.
+std::vector<int> overseer::claim_unstarted_tasks()
+{
+    std::vector<int> claimed;
+    unsigned int size = tasks.size();
+    if (size <= 1)
+    {
+	return claimed;
+    }
+
+    unsigned int count = std::min(size / 2, (unsigned int) MAX_BATCH_SIZE);
+    int task_id = 0;
+    for (unsigned int i = 0; i < count && tasks.pop(task_id); i++)
+    {
+	if (tstatus[task_id].load() != task_status::pruned)
+	{
+	    claimed.push_back(task_id);
+	}
+    }
+
+    return claimed;
+}
+
+void overseer::answer_steal_requests()
+{
+    int request_round = 0;
+    int thief = comm.check_steal_request(request_round);
+    while (thief != -1)
+    {
+	std::vector<int> stolen;
+	if (request_round == round)
+	{
+	    stolen = claim_unstarted_tasks();
+	}
+	print_if<TASK_DEBUG>("Overseer %d: giving %zu tasks to overseer %d.\n", multiprocess::world_rank, stolen.size(), thief);
+	comm.send_stolen_tasks(thief, request_round, stolen);
+	thief = comm.check_steal_request(request_round);
+    }
+}
+
+// When the queen has no more tasks and the local list is almost empty, asks the other
+// overseers one by one. Victims only lose tasks during a round, so after a full cycle
+// of empty responses we stop asking.
+void overseer::steal_if_idle()
+{
+    int peers = multiprocess::overseer_count() - 1;
+    if (peers <= 0)
+    {
+	return;
+    }
+
+    if (steal_requested)
+    {
+	std::vector<int> stolen;
+	int received = comm.try_receiving_stolen_tasks(round, stolen);
+	if (received == -1)
+	{
+	    return;
+	}
+
+	steal_requested = false;
+	if (received == 0)
+	{
+	    empty_steal_responses++;
+	} else
+	{
+	    print_if<TASK_DEBUG>("Overseer %d: stole %d tasks from overseer %d.\n", multiprocess::world_rank, received, steal_victim);
+	    empty_steal_responses = 0;
+	    append_tasks(stolen.data(), stolen.data() + stolen.size());
+	}
+    }
+
+    bool idle = tasks.size() < (size_t) worker_count;
+    if (queue_drained && idle && empty_steal_responses < peers)
+    {
+	// Overseers have ranks 1 to world_size-1; we skip ourselves and the sub-queens.
+	do
+	{
+	    steal_victim = (steal_victim % (multiprocess::world_size - 1)) + 1;
+	} while (steal_victim == multiprocess::world_rank || multiprocess::is_subqueen(steal_victim));
+
+	comm.send_steal_request(steal_victim, round);
+	steal_requested = true;
+    }
+}
+
+void overseer::process_finished_tasks()
+{
+    int ftask_id = 0;
+    while (finished_tasks.pop(ftask_id))
+    {
+	// print_if<true>("Popped task id %d.\n", ftask_id);
+	task_status solution = tstatus[ftask_id].load();
+	if (solution == task_status::alg_win || solution == task_status::adv_win)
 	{
-	    // print_if<true>("Popped task id %d for worker %d.\n", ftask_id, p);
-		
-	    task_status solution = tstatus[ftask_id].load();
-	    if (solution == task_status::alg_win || solution == task_status::adv_win)
+	    if (pending_solutions.empty())
 	    {
-		comm.send_solution_pair(ftask_id, static_cast<int>(solution));
+		oldest_pending_solution = std::chrono::steady_clock::now();
 	    }
-	    ftask_id = finished_tasks[p].pop_if_able();
+	    pending_solutions.push_back(ftask_id);
+	    pending_solutions.push_back(static_cast<int>(solution));
+	    if (TASK_COST_ORDERING)
+	    {
+		pending_timings.push_back(ftask_id);
+		pending_timings.push_back(task_milliseconds[ftask_id]);
+	    }
+	    flush_solutions();
+	}
+    }
+
+    flush_solutions();
+}
+
+// Sends the pending solutions if there are enough of them or if the oldest one has waited
+// long enough.
+void overseer::flush_solutions()
+{
+    if (pending_solutions.empty())
+    {
+	return;
+    }
+
+    std::chrono::duration<double, std::milli> waiting = std::chrono::steady_clock::now() - oldest_pending_solution;
+    if (pending_solutions.size() >= 2*SOLUTION_BATCH_SIZE || waiting.count() >= SOLUTION_FLUSH_MS)
+    {
+	if (USING_RMA_TSTATUS)
+	{
+	    comm.rma_store_solutions(pending_solutions);
+	} else
+	{
+	    comm.send_solutions(pending_solutions);
+	}
+	pending_solutions.clear();
+
+	if (!pending_timings.empty())
+	{
+	    comm.send_task_timings(pending_timings, round);
+	    pending_timings.clear();
 	}
     }
 }
 
+// Receives the task count, the task array and the task statuses of the new round,
+// as broadcast by the queen. Also used by the sub-queens.
+void receive_tarray_tstatus()
+{
+    tcount = comm.bcast_recv_tcount();
+    init_tarray();
+    init_tstatus();
+
+    // Synchronize tarray.
+    if (BULK_TASK_BROADCAST)
+    {
+	comm.bcast_recv_tasks(tarray, tcount);
+    } else
+    {
+	for (int i = 0; i < tcount; i++)
+	{
+	    flat_task transport = comm.bcast_recv_flat_task();
+	    tarray[i].load(transport);
+	}
+    }
+
+    int* tstatus_transport_copy = nullptr;
+    comm.bcast_recv_allocate_tstatus_transport(&tstatus_transport_copy);
+    for (int i = 0; i < tcount; i++)
+    {
+	tstatus[i].store(static_cast<task_status>(tstatus_transport_copy[i]));
+    }
+
+    comm.delete_tstatus_transport(&tstatus_transport_copy);
+}
+
 void overseer::start()
 {
 
@@ -133,7 +337,11 @@ void overseer::start()
     // set global variables based on the settings
     conflog = std::get<0>(settings);
     ht_size = 1LLU << conflog;
-    dplog = std::get<1>(settings);
+    // In the local mode, the queen allocates the shared d.p. cache with this size.
+    if (!LOCAL_COMMUNICATOR)
+    {
+	dplog = std::get<1>(settings);
+    }
 
     // If we want to have a reserve CPU slot for the overseer itself, we should subtract 1.
     worker_count = std::get<2>(settings);
@@ -145,15 +353,36 @@ void overseer::start()
     // compute_thread_ranks();
     comm.send_number_of_workers(worker_count);
     comm.learn_worker_rank();
-    finished_tasks = new semiatomic_q[worker_count];
     std::thread* threads = new std::thread[worker_count];
 
     // conf_el::parallel_init(&ht, ht_size, worker_count); // Init worker cache in parallel.
-    dpc = new guar_cache(dplog);
+    if (!LOCAL_COMMUNICATOR)
+    {
+	dpc = new guar_cache(dplog);
+    }
 
     // Initialize the adversary position (state) cache.
     adv_cache = new state_cache(conflog, worker_count, "adversarial");
 
+    if (USING_DOMINANCE_CACHE)
+    {
+	dom_cache = new dominance_cache(conflog - DOMINANCE_CACHE_SHRINK);
+    }
+
+    if (USING_TABLEBASE)
+    {
+	tb = new endgame_tablebase(TABLEBASE_VOLUME);
+	if (!tb->storage_exists() || !tb->restore())
+	{
+	    print_if<PROGRESS>("Endgame tablebase %s not available, continuing without it.\n", tb->storage_file_path);
+	    delete tb;
+	    tb = nullptr;
+	} else
+	{
+	    print_if<PROGRESS>("Endgame tablebase loaded with %zu elements.\n", tb->table.size());
+	}
+    }
+
     // Initialize the known sum of processing times heuristic, if using it.
     if (USING_HEURISTIC_KNOWNSUM)
     {
@@ -162,7 +391,8 @@ void overseer::start()
 			   knownsum_ub.size());
     }
 
-    if (USING_HEURISTIC_WEIGHTSUM)
+    // In the local mode, the queen initializes the weight heuristics.
+    if (USING_HEURISTIC_WEIGHTSUM && !LOCAL_COMMUNICATOR)
     {
         weight_heurs = new WEIGHT_HEURISTICS;
 	weight_heurs->init_weight_bounds();
@@ -213,27 +443,20 @@ void overseer::start()
 
             // receive (new) task array
 	    
-	    // Attention: this potentially writes the same variable it reads in the local communication model.
-	    tcount = comm.bcast_recv_tcount();
-	    init_tarray();
-	    init_tstatus();
-
-	    // Synchronize tarray.
-	    for (int i = 0; i < tcount; i++)
+	    if (LOCAL_COMMUNICATOR)
+	    {
+		// The queen's tarray and tstatus are ready once the task count arrives.
+		comm.bcast_recv_tcount();
+	    } else
 	    {
-		flat_task transport = comm.bcast_recv_flat_task();
-		tarray[i].load(transport);
+		receive_tarray_tstatus();
 	    }
 
-	    int* tstatus_transport_copy = nullptr;
-	    comm.bcast_recv_allocate_tstatus_transport(&tstatus_transport_copy);
-	    for (int i = 0; i < tcount; i++)
+	    if (USING_RMA_TSTATUS)
 	    {
-		tstatus[i].store(static_cast<task_status>(tstatus_transport_copy[i]));
+		comm.rma_open_window(tcount);
 	    }
 
-	    comm.delete_tstatus_transport(&tstatus_transport_copy);
-
 	    print_if<COMM_DEBUG>("Tarray + tstatus initialized.\n");
 
 	    // Set batch pointer as if the last batch is completed;
@@ -243,12 +466,23 @@ void overseer::start()
 
 	    batch_requested = false;
 	    assert(tasks.size() == 0);
-	    next_task.store(0);
+	    tasks.init(tcount + MAX_BATCH_SIZE);
+	    tasks_appended = 0;
+	    batch_request_size = std::clamp(BATCH_SIZE, smallest_batch_request(), MAX_BATCH_SIZE);
+	    task_rate = 0.0;
+	    tasks_taken_at_request = 0;
+	    last_request_time = std::chrono::steady_clock::now();
+	    round++;
+	    queue_drained = false;
+	    steal_requested = false;
+	    steal_victim = multiprocess::world_rank;
+	    empty_steal_responses = 0;
 
 	    // Reserve space for finished tasks.
-	    for (int w = 0; w < worker_count; w++)
+	    finished_tasks.init(tcount);
+	    if (TASK_COST_ORDERING)
 	    {
-		finished_tasks[w].init(tcount);
+		task_milliseconds.assign(tcount, 0);
 	    }
 
 	    // Wake up all workers and wait for them to set up and go back to sleep.
@@ -259,54 +493,66 @@ void overseer::start()
 	    // Processing loop for an overseer.
 	    while(true)
 	    {
+		uint64_t worker_epoch = overseer_event.epoch();
 		bool r_solved = comm.check_root_solved(w_flags);
 		if (r_solved)
 		{
 		    print_if<PROGRESS>("Overseer %d (on %s): Received root solved, ending round.\n", multiprocess::world_rank, machine_name.c_str());
 
+		    // Wake up the workers waiting for tasks.
+		    task_event.notify();
 		    sleep_until_all_workers_waiting();
 		    break;
 		}
 
 
 		// last time we checked, root_solved == false
+		int pruned = USING_RMA_TSTATUS ? comm.rma_fetch_pruned(tstatus, round) : comm.receive_pruned_tasks(tstatus, round);
+		if (pruned > 0)
+		{
+		    print_if<TASK_DEBUG>("Overseer %d: %d tasks pruned by the queen.\n", multiprocess::world_rank, pruned);
+		}
 		process_finished_tasks();
 
 		// if running low, get new batch
 		// if (BATCH_SIZE - next_task <= BATCH_THRESHOLD)
 		// if (!batch_requested && next_task.load() >= BATCH_SIZE)
-		if (!batch_requested && this->running_low())
+		if (!batch_requested && !queue_drained && this->running_low())
 		{
-		    print_if<TASK_DEBUG>("Overseer %d (on %s): Requesting a new batch (next_task: %u, tasklist: %u). \n", multiprocess::world_rank, machine_name.c_str(), next_task.load(), tasks.size());
+		    print_if<TASK_DEBUG>("Overseer %d (on %s): Requesting a new batch (tasks appended: %u, waiting: %zu). \n", multiprocess::world_rank, machine_name.c_str(), tasks_appended, tasks.size());
 
-		    comm.request_new_batch(multiprocess::world_rank);
+		    update_batch_request_size();
+		    comm.request_new_batch(batch_request_size);
 		    batch_requested = true;
 		}
 
 		if (batch_requested)
 		{
-		    bool batch_received = comm.try_receiving_batch(upcoming_batch);
-		    if (batch_received)
+		    int batch_received = comm.try_receiving_batch(upcoming_batch);
+		    if (batch_received > 0)
 		    {
 			batch_requested = false;
-			std::unique_lock<std::shared_mutex> bplk(batchpointer_mutex);
-
-			// We reset the next_task index first, if it needs resetting.
-			if (next_task.load() > tasks.size())
-			{
-			    next_task.store(tasks.size());
-			}
-
-			tasks.insert(tasks.end(), upcoming_batch.begin(), upcoming_batch.end());
-			bplk.unlock();
+			append_tasks(upcoming_batch.data(), upcoming_batch.data() + batch_received);
 		    }
 		}
 
+		if (USING_WORK_STEALING)
+		{
+		    answer_steal_requests();
+		    steal_if_idle();
+		}
+
 		// The only way to stop the overseer currently is to signal root solved.
-		std::this_thread::sleep_for(std::chrono::milliseconds(TICK_SLEEP));
+		// We wake up early when a worker needs attention; messages from the queen
+		// are only polled, so the tick remains as a fallback.
+		overseer_event.wait_since(worker_epoch, pending_solutions.empty() ? TICK_SLEEP : SOLUTION_FLUSH_MS);
 
 	    } // End of one round for an overseer.
 	    cleanup();
+	    if (USING_RMA_TSTATUS)
+	    {
+		comm.rma_close_window();
+	    }
 	    comm.sync_after_round_end(); 
 	} else { // final_round == true
 	    print_if<COMM_DEBUG>("Overseer %d: received final round, terminating.\n", multiprocess::world_rank);
@@ -341,15 +587,23 @@ void overseer::start()
 							
     
 	    comm.transmit_measurements(ov_meas);
-	    delete dpc;
+	    if (!LOCAL_COMMUNICATOR)
+	    {
+		delete dpc;
+	    }
 	    delete adv_cache;
-	    delete[] finished_tasks;
+	    if (USING_DOMINANCE_CACHE)
+	    {
+		delete dom_cache;
+	    }
+	    delete tb;
+	    tb = nullptr;
 	    comm.sync_after_round_end();
 	    break;
 	}
     }
 
-    if (USING_HEURISTIC_WEIGHTSUM)
+    if (USING_HEURISTIC_WEIGHTSUM && !LOCAL_COMMUNICATOR)
     {
         delete weight_heurs;
     }
@@ -0,0 +1,238 @@
+#ifndef _PARALLEL_GENERATION_HPP
+#define _PARALLEL_GENERATION_HPP 1
+
+#include <atomic>
+#include <algorithm>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "common.hpp"
+#include "dag/dag.hpp"
+#include "saplings.hpp"
+#include "minimax/computation.hpp"
+#include "minimax/recursion.hpp"
+
+// Parallel generation of a sapling on the queen. The generation first runs as usual down to
+// GENERATION_SPLIT_DEPTH, leaving the fresh adversary vertices there (the frontier) untouched.
+// The subtrees of the frontier vertices are independent, so GENERATION_THREADS threads generate
+// them, each into a DAG of its own, holding a copy of the frontier vertex only.
+
+// The DAGs are then grafted into the main DAG in the order of the frontier. A position which
+// the main DAG already contains is taken from there, if it has been visited by this generation
+// -- this is where the sequential generation would have stopped as well. If some other position
+// is shared, the subtree is thrown away and generated sequentially in the main DAG.
+
+// Finally, the values of the vertices above the frontier (and above the shared positions)
+// are recomputed, pruning the edges the sequential generation would not have kept.
+
+template <int MINIBS_SCALE> void restore_frontier_state(computation<minimax::generating, MINIBS_SCALE> *comp,
+		const typename computation<minimax::generating, MINIBS_SCALE>::frontier_vertex &f)
+{
+    duplicate(&(comp->bstate), &(f.v->bc));
+    comp->bstate.hashinit();
+    comp->itemdepth = comp->bstate.itemcount_explicit();
+    comp->calldepth = f.calldepth;
+    comp->largest_since_computation_root = f.largest_since_computation_root;
+    comp->prev_max_feasible = f.prev_max_feasible;
+    comp->ol = f.ol;
+    comp->bstate_weight_array = f.bstate_weight_array;
+
+    if (USING_MINIBINSTRETCHING)
+    {
+	comp->scaled_items->initialize(comp->bstate);
+    }
+}
+
+void relabel_after_grafting(dag *d, algorithm_vertex *v);
+
+// Recomputes the values of the vertices visited by the generation, bottom-up.
+void relabel_after_grafting(dag *d, adversary_vertex *v)
+{
+    if (v->visited_secondary || !v->visited || v->leaf == leaf_type::heuristical
+	|| (v->state != vert_state::fresh && v->state != vert_state::expanding))
+    {
+	return;
+    }
+    v->visited_secondary = true;
+
+    for (adv_outedge *e : v->out)
+    {
+	relabel_after_grafting(d, e->to);
+    }
+
+    if (v->out.empty())
+    {
+	return;
+    }
+
+    victory win = victory::alg;
+    for (adv_outedge *e : v->out)
+    {
+	if (e->to->win == victory::adv)
+	{
+	    win = victory::adv;
+	    d->remove_outedges_except<minimax::generating>(v, e->item);
+	    break;
+	} else if (e->to->win == victory::uncertain)
+	{
+	    win = victory::uncertain;
+	}
+    }
+
+    if (win != victory::adv)
+    {
+	auto it = v->out.begin();
+	while (it != v->out.end())
+	{
+	    adv_outedge *e = *it;
+	    it++;
+	    if (e->to->win == victory::alg)
+	    {
+		d->remove_edge<minimax::generating>(e);
+	    }
+	}
+    }
+
+    v->win = win;
+}
+
+void relabel_after_grafting(dag *d, algorithm_vertex *v)
+{
+    if (v->visited_secondary || !v->visited || v->leaf == leaf_type::heuristical
+	|| (v->state != vert_state::fresh && v->state != vert_state::expanding))
+    {
+	return;
+    }
+    v->visited_secondary = true;
+
+    for (alg_outedge *e : v->out)
+    {
+	relabel_after_grafting(d, e->to);
+    }
+
+    if (v->out.empty())
+    {
+	return;
+    }
+
+    victory win = victory::adv;
+    for (alg_outedge *e : v->out)
+    {
+	if (e->to->win == victory::alg)
+	{
+	    win = victory::alg;
+	    break;
+	} else if (e->to->win == victory::uncertain)
+	{
+	    win = victory::uncertain;
+	}
+    }
+
+    if (win == victory::alg)
+    {
+	d->remove_outedges<minimax::generating>(v);
+    }
+
+    v->win = win;
+}
+
+// A drop-in replacement of generate(). Only evaluation saplings with no generated vertices
+// below them are split; the rest is generated sequentially.
+template <int MINIBS_SCALE> victory generate_parallel(sapling job,
+		computation<minimax::generating, MINIBS_SCALE> *comp)
+{
+    using comp_type = computation<minimax::generating, MINIBS_SCALE>;
+
+    if (!PARALLEL_GENERATION || !job.evaluation || !job.root->out.empty())
+    {
+	return generate<minimax::generating>(job, comp);
+    }
+
+    comp->split_depth = GENERATION_SPLIT_DEPTH;
+    comp->frontier.clear();
+    victory top = generate<minimax::generating>(job, comp);
+    comp->split_depth = 0;
+
+    // Some frontier vertices were deleted when their ancestors got decided, and a position
+    // may have been recorded again after its deletion; only the last record is valid.
+    std::vector<typename comp_type::frontier_vertex> frontier;
+    std::unordered_set<uint64_t> recorded;
+    for (auto it = comp->frontier.rbegin(); it != comp->frontier.rend(); it++)
+    {
+	auto living = comp->gen_dag->adv_by_hash.find(it->hash);
+	if (living != comp->gen_dag->adv_by_hash.end() && living->second == it->v
+	    && recorded.insert(it->hash).second)
+	{
+	    frontier.push_back(*it);
+	}
+    }
+    std::reverse(frontier.begin(), frontier.end());
+    comp->frontier.clear();
+
+    if (frontier.empty())
+    {
+	return top;
+    }
+
+    std::vector<dag*> sides(frontier.size(), nullptr);
+    std::atomic<unsigned int> next_vertex(0);
+    std::vector<std::thread> generators;
+
+    for (int t = 0; t < GENERATION_THREADS; t++)
+    {
+	generators.emplace_back([&]() {
+	    comp_type side_comp;
+	    side_comp.regrow_level = comp->regrow_level;
+	    side_comp.bounds = comp->bounds;
+	    side_comp.assumer = comp->assumer;
+	    side_comp.weight_heurs = comp->weight_heurs;
+	    side_comp.mbs = comp->mbs;
+
+	    unsigned int i = 0;
+	    while ((i = next_vertex.fetch_add(1)) < frontier.size())
+	    {
+		adversary_vertex *original = frontier[i].v;
+		dag *side = new dag;
+		adversary_vertex *root_copy = side->add_root(original->bc);
+		root_copy->sapling = original->sapling;
+		root_copy->state = original->state;
+		root_copy->regrow_level = original->regrow_level;
+
+		side_comp.gen_dag = side;
+		restore_frontier_state(&side_comp, frontier[i]);
+		side_comp.adversary(root_copy, nullptr);
+		sides[i] = side;
+	    }
+	});
+    }
+
+    for (std::thread& generator : generators)
+    {
+	generator.join();
+    }
+
+    int regenerated = 0;
+    for (unsigned int i = 0; i < frontier.size(); i++)
+    {
+	if (!comp->gen_dag->graft(sides[i], frontier[i].v, true))
+	{
+	    sides[i]->free_vertices();
+	    delete sides[i];
+
+	    frontier[i].v->visited = false;
+	    restore_frontier_state(comp, frontier[i]);
+	    comp->adversary(frontier[i].v, nullptr);
+	    regenerated++;
+	}
+    }
+
+    comp->gen_dag->clear_visited_secondary();
+    relabel_after_grafting(comp->gen_dag, job.root);
+
+    print_if<VERBOSE>("Queen: Generated %zu subtrees in parallel, %d of them again sequentially.\n",
+		      frontier.size(), regenerated);
+    return job.root->win;
+}
+
+#endif // _PARALLEL_GENERATION_HPP
@@ -0,0 +1,147 @@
+#ifndef _PIPELINING_HPP
+#define _PIPELINING_HPP 1
+
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "dag/dag.hpp"
+#include "saplings.hpp"
+#include "minimax/computation.hpp"
+#include "minimax/recursion.hpp"
+#include "minibs.hpp"
+
+// Pipelining of saplings. While the overseers solve the tasks of the current sapling,
+// a thread of the queen generates the sapling which is likely to come next. The
+// generation cannot happen in the main DAG, as the updater edits it during the round,
+// so the speculative sapling gets a DAG of its own, holding a copy of its root only.
+
+// Once the round ends and the next job is known, graft() checks that the guess was right
+// and moves the generated vertices into the main DAG, in place of the generation phase.
+// The speculative DAG may contain positions which are also present in the main DAG.
+// If the adversary wins them there, the edges are redirected to the main DAG's vertices;
+// otherwise the speculation is thrown away and the sapling is generated again.
+
+class sapling_pipeline
+{
+public:
+    dag *speculative_dag = nullptr;
+    sapling speculative_job;
+    uint64_t origin_hash = 0;
+    task_bounds bounds;
+    victory result = victory::uncertain;
+    std::thread generator;
+
+    int grafted = 0;
+    int discarded = 0;
+
+    void start(const sapling& next, const assumptions& assumer,
+	       WEIGHT_HEURISTICS *weight_heurs, minibs<MINIBS_SCALE_QUEEN> *mbs);
+    void wait();
+    bool graft(dag *d, sapling& job, victory& generated);
+    void discard();
+};
+
+// Only evaluation saplings with no generated vertices below them are speculated on;
+// an expansion sapling would require a copy of its subdag.
+void sapling_pipeline::start(const sapling& next, const assumptions& assumer,
+			     WEIGHT_HEURISTICS *weight_heurs, minibs<MINIBS_SCALE_QUEEN> *mbs)
+{
+    assert(speculative_dag == nullptr);
+    if (next.root == nullptr || !next.evaluation || !next.root->out.empty())
+    {
+	return;
+    }
+
+    origin_hash = next.root->bc.hash_with_last();
+    bounds = next.bounds();
+    result = victory::uncertain;
+
+    speculative_dag = new dag;
+    adversary_vertex *root_copy = speculative_dag->add_root(next.root->bc);
+    root_copy->sapling = true;
+    root_copy->state = next.root->state;
+    root_copy->leaf = next.root->leaf;
+    root_copy->regrow_level = next.root->regrow_level;
+    speculative_job = next;
+    speculative_job.root = root_copy;
+
+    print_if<PROGRESS>("Queen: Speculatively generating the next sapling:\n");
+    print_binconf<PROGRESS>(next.root->bc);
+
+    generator = std::thread([this, assumer, weight_heurs, mbs]() {
+	computation<minimax::generating, MINIBS_SCALE_QUEEN> comp;
+	comp.regrow_level = speculative_job.regrow_level;
+	comp.gen_dag = speculative_dag;
+	comp.bounds = bounds;
+
+	if (USING_ASSUMPTIONS)
+	{
+	    comp.assumer = assumer;
+	}
+
+	if (USING_HEURISTIC_WEIGHTSUM)
+	{
+	    comp.weight_heurs = weight_heurs;
+	}
+
+	if (USING_MINIBINSTRETCHING)
+	{
+	    comp.mbs = mbs;
+	}
+
+	speculative_dag->clear_visited();
+	result = generate<minimax::generating>(speculative_job, &comp);
+    });
+}
+
+void sapling_pipeline::wait()
+{
+    if (generator.joinable())
+    {
+	generator.join();
+    }
+}
+
+// Replaces the generation of the job in d by the speculative one, if it is the same sapling.
+// Returns false (and discards the speculation) otherwise.
+bool sapling_pipeline::graft(dag *d, sapling& job, victory& generated)
+{
+    wait();
+    if (speculative_dag == nullptr)
+    {
+	return false;
+    }
+
+    // Positions which d already contains must be won by the adversary there, as the
+    // regular generation would then have stopped at them.
+    bool usable = job.evaluation && job.root->out.empty()
+	&& job.root->bc.hash_with_last() == origin_hash && job.bounds() == bounds;
+
+    if (!usable || !d->graft(speculative_dag, job.root, false))
+    {
+	discard();
+	return false;
+    }
+
+    speculative_dag = nullptr;
+    generated = result;
+    grafted++;
+    return true;
+}
+
+void sapling_pipeline::discard()
+{
+    wait();
+    if (speculative_dag == nullptr)
+    {
+	return;
+    }
+
+    speculative_dag->free_vertices();
+    delete speculative_dag;
+    speculative_dag = nullptr;
+    discarded++;
+}
+
+#endif // _PIPELINING_HPP
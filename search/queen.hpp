@@ -16,6 +16,7 @@
 #include "weights/scale_thirds.hpp"
 #include "weights/scale_quarters.hpp"
 #include "minibs.hpp"
+#include "wakeup.hpp"
 
 // Queen global variables and declarations.
 
@@ -31,14 +32,20 @@ class queen_class
 {
 public:
     std::atomic<bool> updater_running = false;
+    // Signalled by the main thread when solutions are collected.
+    wakeup_event updater_event;
+    // Signalled by the updater thread when it finishes.
+    wakeup_event queen_event;
     char root_binconf_file[256];
     bool load_root_binconf = false;
+    // The number of rounds started so far; the overseers count them the same way.
+    int round = 0;
 
     WEIGHT_HEURISTICS* weight_heurs = nullptr;
     minibs<MINIBS_SCALE_QUEEN>* mbs = nullptr;
 
     queen_class(int argc, char **argv);
-    void updater(sapling job);
+    void updater(std::vector<sapling> jobs);
     int start();
 
     // Returns true if the updater thread should do an update, since
@@ -7,12 +7,19 @@
 #include "updater.hpp"
 #include "minimax/sequencing.hpp"
 #include "tasks.hpp"
+#include "task_cost.hpp"
 #include "net/batches.hpp"
 #include "server_properties.hpp"
 // #include "loadfile.hpp"
 #include "saplings.hpp"
 #include "savefile.hpp"
 #include "performance_timer.hpp"
+#include "pipelining.hpp"
+#include "parallel_generation.hpp"
+#include "checkpoint.hpp"
+#include "autotuning.hpp"
+#include "estimation.hpp"
+#include "task_store.hpp"
 #include "queen.hpp"
 /*
 
@@ -33,26 +40,65 @@ queen_class::queen_class(int argc, char** argv)
 {
 }
 
-void queen_class::updater(sapling job)
+// The updater evaluates all saplings of the round, each with its own updater_computation.
+// A sapling which is decided drops out (its remaining tasks are pruned by the last update),
+// and the round ends once all of them are decided, or as soon as the algorithm wins one.
+void queen_class::updater(std::vector<sapling> jobs)
 {
 
     unsigned int last_printed = 0;
-    qmemory::collected_cumulative = 0;
-    reset_collected_now();
     unsigned int cycle_counter = 0;
-    updater_computation ucomp(qdag, job);
+    std::vector<updater_computation> ucomps;
+    for (const sapling& job : jobs)
+    {
+	ucomps.emplace_back(qdag, job);
+    }
+    std::vector<bool> active(ucomps.size(), true);
+    unsigned int active_count = ucomps.size();
+    round_eta eta;
+    eta.start();
     
     // while (ucomp.root_result == victory::uncertain && ucomp.updater_result == victory::uncertain)
-    while (ucomp.continue_updating())
+    while (active_count > 0)
     {
-	std::this_thread::sleep_for(std::chrono::milliseconds(TICK_SLEEP));
+	uint64_t collect_epoch = updater_event.epoch();
+	if (!update_recommendation())
+	{
+	    updater_event.wait_since(collect_epoch);
+	}
 	// unsigned int currently_collected = collect_tasks();
 	// qmemory::collected_cumulative += currently_collected;
 	// collected_no += currently_collected;
 	if (qmemory::collected_cumulative.load(std::memory_order_acquire) / PROGRESS_AFTER > last_printed)
 	{
 	    last_printed = qmemory::collected_cumulative / PROGRESS_AFTER;
-	    print_if<PROGRESS>("Queen collects task number %u. \n", qmemory::collected_cumulative.load(std::memory_order_acquire));
+	    unsigned int collected = qmemory::collected_cumulative.load(std::memory_order_acquire);
+
+	    // The updaters know how many tasks their saplings still need. Before the first
+	    // update, or if the saplings share tasks, the tasks not collected yet are counted.
+	    uint64_t uncollected = ((unsigned int) tcount > collected) ? tcount - collected : 0;
+	    uint64_t remaining = 0;
+	    for (unsigned int i = 0; i < ucomps.size(); i++)
+	    {
+		if (active[i])
+		{
+		    remaining += ucomps[i].unfinished_tasks;
+		}
+	    }
+	    if (remaining == 0 || remaining > uncollected)
+	    {
+		remaining = uncollected;
+	    }
+
+	    double seconds_left = eta.seconds_left(collected, remaining);
+	    if (seconds_left >= 0.0)
+	    {
+		print_if<PROGRESS>("Queen collects task number %u, %" PRIu64 " tasks remain, the round ends in about %s.\n",
+				   collected, remaining, format_duration(seconds_left).c_str());
+	    } else
+	    {
+		print_if<PROGRESS>("Queen collects task number %u. \n", collected);
+	    }
 	}
 	
 	// update main tree and task map
@@ -61,72 +107,92 @@ void queen_class::updater(sapling job)
 	{
 	    reset_collected_now();
 	    cycle_counter++;
-	    ucomp.update();
-	    if (cycle_counter >= 100)
+	    std::vector<int> finished_ids;
+	    if (INCREMENTAL_UPDATER)
 	    {
-		print_if<VERBOSE>("Update: Visited %" PRIu64 " verts, unfinished tasks in tree: %" PRIu64 ".\n",
-			   ucomp.vertices_visited, ucomp.unfinished_tasks);
+		finished_ids = take_finished_pending();
+	    }
 
-		if(VERBOSE)
+	    for (unsigned int i = 0; i < ucomps.size(); i++)
+	    {
+		if (!active[i])
 		{
-		    job.print_sapling(stderr);
+		    continue;
 		}
 
-		if(ucomp.unfinished_tasks == 0 && job.root->win == victory::uncertain)
+		updater_computation& ucomp = ucomps[i];
+		if (INCREMENTAL_UPDATER)
 		{
-		    /*
-		    FILE *flog = fopen("./logs/uncertain-job.log", "w");
-		    qdag->clear_visited();
-		    qdag->print_lowerbound_dfs(job.root, flog, true);
-		    fclose(flog);
-		    */
-		    
-		}
-		if (VERBOSE && ucomp.unfinished_tasks <= 10)
+		    ucomp.update_incremental(finished_ids);
+		} else
 		{
-		    // print_unfinished_with_binconf(job.root);
+		    ucomp.update();
 		}
 
-		if (TASK_DEBUG)
+		if (cycle_counter >= 100)
 		{
-		    // print_unfinished(job.root);
-		}
-		
-		cycle_counter = 0;
-	    }
-
-	    if (!ucomp.continue_updating()) 
-	    {
-		print_if<PROGRESS>("Updater: Sapling updating finished. ");
+		    print_if<VERBOSE>("Update: Visited %" PRIu64 " verts, unfinished tasks in tree: %" PRIu64 ".\n",
+				      ucomp.vertices_visited, ucomp.unfinished_tasks);
 
-		// If the graph looks evaluated, we just run one more
-		// update of the root to make sure the
-		// winning states are propagated well, that the tasks with adv-winning are removed, and
-		// so forth.
+		    if(VERBOSE)
+		    {
+			ucomp.job.print_sapling(stderr);
+		    }
 
-		if (ucomp.updater_result == victory::adv)
-		{
-		    // print_if<PROGRESS>("Updater: Updating once from the root.\n");
-		    ucomp.update_root();
+		    if (TASK_DEBUG)
+		    {
+			// print_unfinished(ucomp.job.root);
+		    }
 		}
 
-		if (VERBOSE)
+		if (!ucomp.continue_updating()) 
 		{
-		    fprintf(stderr, "updater=");
-		    print(stderr, ucomp.updater_result);
-		    fprintf(stderr, " root=");
-		    print(stderr, ucomp.root_result);
-		    fprintf(stderr, "\n");
-		}
+		    print_if<PROGRESS>("Updater: Sapling updating finished. ");
+
+		    // If the graph looks evaluated, we just run one more
+		    // update of the root to make sure the
+		    // winning states are propagated well, that the tasks with adv-winning are removed, and
+		    // so forth.
 
-		print_if<MEASURE>("Prune/receive collisions: %" PRIu64 ".\n", g_meas.pruned_collision);
-		g_meas.pruned_collision = 0;
+		    if (ucomp.updater_result == victory::adv)
+		    {
+			// print_if<PROGRESS>("Updater: Updating once from the root.\n");
+			ucomp.update_root();
+		    }
+
+		    if (VERBOSE)
+		    {
+			fprintf(stderr, "updater=");
+			print(stderr, ucomp.updater_result);
+			fprintf(stderr, " root=");
+			print(stderr, ucomp.root_result);
+			fprintf(stderr, "\n");
+		    }
+
+		    print_if<MEASURE>("Prune/receive collisions: %" PRIu64 ".\n", g_meas.pruned_collision);
+		    g_meas.pruned_collision = 0;
 		
-		assert(ucomp.updater_result != victory::uncertain);
+		    assert(ucomp.updater_result != victory::uncertain);
+		    active[i] = false;
+		    active_count--;
+
+		    // The other saplings do not matter if the algorithm wins this one.
+		    if (ucomp.updater_result == victory::alg)
+		    {
+			active_count = 0;
+			break;
+		    }
+		}
+	    }
+
+	    if (cycle_counter >= 100)
+	    {
+		cycle_counter = 0;
 	    }
 	}
     }
     updater_running.store(false);
+    queen_event.notify();
 }
 
 int queen_class::start()
@@ -144,11 +210,19 @@ int queen_class::start()
 
     comm.compute_thread_ranks();
     // init_running_lows();
-    batches batching(multiprocess::overseer_count());
+    // Batches are indexed by rank; the queen sends them to its children, which are
+    // either all the overseers or the sub-queens.
+    batches batching(multiprocess::world_size - 1);
+    const std::vector<int> children = multiprocess::children();
     
     // std::tuple<unsigned int, unsigned int, unsigned int> settings = server_properties(processor_name);
     // out of the settings, queen does not spawn workers or use ht, only dpht
     dplog = QUEEN_DPLOG;
+    // In the local mode, the overseer shares this cache, so it gets the size meant for the workers.
+    if (LOCAL_COMMUNICATOR)
+    {
+	dplog = std::max(dplog, std::get<1>(server_properties(gethost().c_str())));
+    }
     // Init queen memory (the queen does not use the main solved cache):
     dpc = new guar_cache(dplog); 
 
@@ -166,8 +240,47 @@ int queen_class::start()
 	assumer.load_file(ASSUMPTIONS_FILENAME);
     }
 
+    task_cost_model cost_model;
+    task_timings timings;
+    if (TASK_COST_ORDERING)
+    {
+	cost_model.train();
+    }
+
+    task_autotuner autotuner(&cost_model);
+    work_estimator estimator;
+    solved_task_store task_store;
+    if (TASK_STORE && !ESTIMATING)
+    {
+	task_store.load();
+    }
+
 
-    if (CUSTOM_ROOTFILE)
+    checkpoint checkpointer;
+    queen_counters counters;
+    qdag = nullptr;
+    bool resumed = false;
+    if (RESUMING && checkpointer.exists())
+    {
+	qdag = checkpointer.load_dag(counters);
+	resumed = (qdag != nullptr);
+	if (resumed)
+	{
+	    checkpointer.load_solutions();
+	}
+    } else if (RESUMING)
+    {
+	print_if<PROGRESS>("Queen: No checkpoint found, starting from the beginning.\n");
+    } else if (CHECKPOINTING && !ESTIMATING)
+    {
+	// A checkpoint of some previous run is not to be resumed later.
+	checkpointer.remove();
+    }
+
+    if (resumed)
+    {
+	// The treetop is already present in the stored DAG.
+    } else if (CUSTOM_ROOTFILE)
     {
 	qdag = new dag;
 	binconf root = loadbinconf_singlefile(ROOT_FILENAME);
@@ -182,6 +295,15 @@ int queen_class::start()
     }
 
     sapling_manager sap_man(qdag);
+    sapling_pipeline pipeline;
+
+    if (resumed)
+    {
+	sapling_no = counters.round;
+	winning_saplings = counters.winning_saplings;
+	sap_man.evaluation = counters.evaluation;
+	sap_man.expansion = counters.expansion;
+    }
 
     // update_and_count_saplings(qdag); // Leave only uncertain saplings.
 
@@ -194,12 +316,37 @@ int queen_class::start()
 	perf_timer.new_sapling_start();
 	perf_timer.init_phase_start();
 
+	if (CHECKPOINTING && !ESTIMATING)
+	{
+	    checkpointer.save_dag(qdag, {sapling_no, winning_saplings, sap_man.evaluation, sap_man.expansion});
+	}
 
 	job.mark_in_progress();
 
 	print_if<PROGRESS>("Queen: Monotonicity %d, Sapling count: %ld, current sapling of regrow level %d:\n", monotonicity, sapling_counter, job.regrow_level);
 	print_binconf<PROGRESS>(job.root->bc);
 
+	// Further uncertain saplings which are evaluated in the same round.
+	std::vector<sapling> companions;
+	std::vector<adversary_vertex*> round_roots = {job.root};
+	while (job.evaluation && !ESTIMATING && (int) round_roots.size() < SAPLINGS_PER_ROUND)
+	{
+	    sapling companion = sap_man.find_next_uncertain(round_roots);
+	    if (companion.root == nullptr)
+	    {
+		break;
+	    }
+
+	    companion.mark_in_progress();
+	    print_if<PROGRESS>("Queen: Evaluating also the sapling:\n");
+	    print_binconf<PROGRESS>(companion.root->bc);
+	    if (AUTOTUNING)
+	    {
+		autotuner.tune(companion);
+	    }
+	    companions.push_back(companion);
+	    round_roots.push_back(companion.root);
+	}
 
 	computation_root = job.root;
 
@@ -224,8 +371,14 @@ int queen_class::start()
 	}
 	*/
 	
-	task_depth = TASK_DEPTH_INIT + job.regrow_level * TASK_DEPTH_STEP;
-	task_load = TASK_LOAD_INIT + job.regrow_level * TASK_LOAD_STEP;
+	if (AUTOTUNING)
+	{
+	    autotuner.tune(job);
+	}
+
+	task_bounds bounds = job.bounds();
+	task_depth = bounds.depth;
+	task_load = bounds.load;
 
 	// We do not regrow with a for loop anymore, we regrow using the job system in the DAG instead.
 	/*
@@ -237,6 +390,8 @@ int queen_class::start()
 
 	computation<minimax::generating, MINIBS_SCALE_QUEEN> comp;
 	comp.regrow_level = job.regrow_level;
+	comp.gen_dag = qdag;
+	comp.bounds = bounds;
 
 	if (USING_ASSUMPTIONS)
 	{
@@ -248,7 +403,8 @@ int queen_class::start()
 	    comp.weight_heurs = weight_heurs;
 	}
 
-	if (USING_MINIBINSTRETCHING)
+	// With pipelining, the cache is kept for the speculative generation as well.
+	if (USING_MINIBINSTRETCHING && mbs == nullptr)
 	{
 	    // The minibinstretching allocation happens here, so that the memory
 	    // can be freed as soon as possible.
@@ -261,6 +417,10 @@ int queen_class::start()
 	    // Note: the next command is not executed by the overseer, as we wish to backup
 	    // the calculations only by one process, and not have two write to a file at the same time.
 	    mbs->backup_calculations();
+	}
+
+	if (USING_MINIBINSTRETCHING)
+	{
 	    comp.mbs = mbs;
 	}
 
@@ -276,16 +436,41 @@ int queen_class::start()
 	perf_timer.init_phase_end();
 	perf_timer.generation_phase_start();
 
-	updater_result = generate<minimax::generating>(job, &comp);
+	victory generated = victory::uncertain;
+	if (SAPLING_PIPELINING && pipeline.graft(qdag, job, generated))
+	{
+	    print_if<PROGRESS>("Queen: The sapling was generated during the previous round.\n");
+	} else
+	{
+	    generated = generate_parallel(job, &comp);
+	}
+	updater_result = generated;
+
+	// The visited flags are kept, so that positions shared with the previous saplings
+	// are not generated again.
+	for (sapling& companion : companions)
+	{
+	    computation_root = companion.root;
+	    comp.regrow_level = companion.regrow_level;
+	    comp.bounds = companion.bounds();
+	    companion.root->win = generate_parallel(companion, &comp);
+	}
+	computation_root = job.root;
+
 	mark_tasks(qdag, job);
+	for (sapling& companion : companions)
+	{
+	    mark_tasks(qdag, companion);
+	}
 
 	MEASURE_ONLY(comp.meas.print_generation_stats());
 	MEASURE_ONLY(comp.meas.clear_generation_stats());
 
-	if (USING_MINIBINSTRETCHING)
+	if (USING_MINIBINSTRETCHING && !SAPLING_PIPELINING)
 	{
 	    print_if<PROGRESS>("Queen: freeing minibinstretching cache.\n");
-	    delete comp.mbs;
+	    delete mbs;
+	    mbs = nullptr;
 	    malloc_trim(0);
 	}
 
@@ -293,26 +478,60 @@ int queen_class::start()
 
 	computation_root->win = updater_result.load(std::memory_order_acquire);
 
-	print_if<VERBOSE>("Consistency check after generation.\n");
-	consistency_checker c_after_gen(qdag, false);
-	c_after_gen.check();
+	std::vector<sapling> round_jobs = {job};
+	round_jobs.insert(round_jobs.end(), companions.begin(), companions.end());
+	std::vector<sapling> undecided;
+	adversary_vertex *losing_root = nullptr;
+	for (const sapling& j : round_jobs)
+	{
+	    if (j.root->win == victory::uncertain)
+	    {
+		undecided.push_back(j);
+	    } else if (j.root->win == victory::alg && losing_root == nullptr)
+	    {
+		losing_root = j.root;
+	    }
+	}
+
+	// A sapling won by the algorithm ends the computation; the checker only accepts
+	// such a vertex at the root of the graph.
+	if (losing_root == nullptr)
+	{
+	    print_if<VERBOSE>("Consistency check after generation.\n");
+	    consistency_checker c_after_gen(qdag, false);
+	    c_after_gen.check();
+	}
 
 	// If we have already finished via generation, we skip the parallel phase.
 	// We still enter the cleanup phase.
-	if (computation_root->win != victory::uncertain)
+	if (losing_root != nullptr || undecided.empty())
 	{
 	    print_if<VERBOSE>("Queen: Completed lower bound in the generation phase.\n");
-	    if (computation_root->win == victory::adv)
-	    {
-		winning_saplings++;
-	    } else if (computation_root->win == victory::alg)
+	    if (losing_root != nullptr)
 	    {
 		losing_saplings++;
-		losing_binconf = job.root->bc;
+		losing_binconf = losing_root->bc;
 		ret = 1;
 		break;
 	    }
 	// --- END GENERATION PHASE ---
+	} else if (ESTIMATING)
+	{
+	    // Instead of the parallel phase, a sample of the tasks is solved by the queen.
+	    collect_tasks(job.root);
+	    init_tstatus(tstatus_temporary); tstatus_temporary.clear();
+	    init_tarray(tarray_temporary); tarray_temporary.clear();
+	    print_if<PROGRESS>("Queen: Generated %d tasks.\n", tcount);
+	    estimator.sample(job, weight_heurs);
+	    destroy_tarray();
+	    destroy_tstatus();
+
+	    // The sapling stays uncertain; it is only no longer looked for.
+	    job.root->sapling = false;
+	    sapling_counter = sap_man.count_saplings();
+	    job = sap_man.find_sapling();
+	    sapling_no++;
+	    continue;
 	// --- BEGIN PARALLEL PHASE ---
 	} else {
 	    perf_timer.parallel_phase_start();
@@ -321,8 +540,14 @@ int queen_class::start()
 	    print_if<COMM_DEBUG>("Queen: Starting the round.\n");
 	    batching.clear();
 	    comm.round_start_and_finality(false);
+	    round++;
 
-	    collect_tasks(computation_root);
+	    std::vector<adversary_vertex*> undecided_roots;
+	    for (const sapling& j : undecided)
+	    {
+		undecided_roots.push_back(j.root);
+	    }
+	    collect_tasks(undecided_roots);
 	    init_tstatus(tstatus_temporary); tstatus_temporary.clear();
 	    init_tarray(tarray_temporary); tarray_temporary.clear();
 
@@ -332,76 +557,179 @@ int queen_class::start()
 	    // to a lot of failures early, but these failures will be quick.
 
 	    // permute_tarray_tstatus(); // We do not permute currently.
-	    reverse_tarray_tstatus();
+	    // With a trained cost model, we instead put the most expensive tasks first,
+	    // so that they do not form the tail of the round.
+	    if (TASK_COST_ORDERING && cost_model.trained)
+	    {
+		std::vector<double> cost(tcount);
+		for (int i = 0; i < tcount; i++)
+		{
+		    cost[i] = cost_model.predict(tarray[i]);
+		}
+		sort_tarray_tstatus_by_cost(cost);
+	    } else
+	    {
+		reverse_tarray_tstatus();
+	    }
 
 	    // print_tasks(); // Large debug print.
 
+	    // The counters are reset before the tasks solved prior to a resumption
+	    // are marked, so that the updater processes them at once.
+	    qmemory::collected_cumulative = 0;
+	    reset_collected_now();
+	    checkpointer.apply_solutions(sapling_no);
+	    if (TASK_STORE)
+	    {
+		task_store.apply();
+	    }
+
 	    // irrel_taskq.init(tcount);
 	    // note: do not push into irrel_taskq before permutation is done;
 	    // the numbers will not make any sense.
 
 	    print_if<PROGRESS>("Queen: Generated %d tasks.\n", tcount);
+	    if (AUTOTUNING)
+	    {
+		autotuner.calibrate(undecided, tcount);
+	    }
+
 	    comm.bcast_send_tcount(tcount);
-	    // Synchronize tarray.
-	    for (int i = 0; i < tcount; i++)
+	    // In the local mode, the overseer uses tarray and tstatus of the queen directly.
+	    if (!LOCAL_COMMUNICATOR)
 	    {
-		flat_task transport = tarray[i].flatten();
-		comm.bcast_send_flat_task(transport);
+		// Synchronize tarray.
+		if (BULK_TASK_BROADCAST)
+		{
+		    comm.bcast_send_tasks(tarray, tcount);
+		} else
+		{
+		    for (int i = 0; i < tcount; i++)
+		    {
+			flat_task transport = tarray[i].flatten();
+			comm.bcast_send_flat_task(transport);
+		    }
+		}
+
+		// Synchronize tstatus.
+		int *tstatus_transport_copy = new int[tcount];
+		for (int i = 0; i < tcount; i++)
+		{
+		    tstatus_transport_copy[i] = static_cast<int>(tstatus[i].load());
+		}
+		// After "de-atomizing" it, pass it to all overseers.
+		comm.bcast_send_tstatus_transport(tstatus_transport_copy, tcount);
+		delete[] tstatus_transport_copy;
 	    }
 
-	    // Synchronize tstatus.
-	    int *tstatus_transport_copy = new int[tcount];
-	    for (int i = 0; i < tcount; i++)
+	    if (USING_RMA_TSTATUS)
 	    {
-		tstatus_transport_copy[i] = static_cast<int>(tstatus[i].load());
+		comm.rma_open_window(tcount);
 	    }
-	    // After "de-atomizing" it, pass it to all overseers.
-	    comm.bcast_send_tstatus_transport(tstatus_transport_copy, tcount);
-	    delete[] tstatus_transport_copy;
 
 	    print_if<PROGRESS>("Queen: Tasks synchronized.\n");
 
 	    // broadcast_tarray_tstatus();
 	    taskpointer = 0;
 
+	    // The next sapling is found before the updater starts, as both use the visited flags.
+	    if (SAPLING_PIPELINING)
+	    {
+		sapling next = sap_man.find_next_uncertain(round_roots);
+		if (AUTOTUNING && next.root != nullptr)
+		{
+		    autotuner.tune(next);
+		}
+		pipeline.start(next, assumer, weight_heurs, mbs);
+	    }
+
 	    updater_running.store(true);
-	    auto x = std::thread(&queen_class::updater, this, job);
+	    auto x = std::thread(&queen_class::updater, this, undecided);
 	    // wake up updater thread.
 
 	    // Main loop of this thread (the variable is updated by the other thread).
 	    while (updater_running.load())
 	    {
+		uint64_t updater_epoch = queen_event.epoch();
 		collect_worker_tasks();
+		if (TASK_COST_ORDERING)
+		{
+		    comm.collect_task_timings(timings.pending, round);
+		}
+		if (CHECKPOINTING && checkpointer.due())
+		{
+		    checkpointer.save_solutions(sapling_no);
+		}
+
+		if (update_recommendation())
+		{
+		    updater_event.notify();
+		}
 		comm.collect_runlows(); // collect_running_lows();
 
 		// We wish to have the loop here, so that net/ is independent on compose_batch().
-		for (int overseer = 1; overseer <= multiprocess::overseer_count(); overseer++)
+		for (int child : children)
 		{
-		    if (comm.is_running_low(overseer))
+		    if (comm.is_running_low(child))
 		    {
-			//check_batch_finished(overseer);
-			batching.compose_batch(overseer, taskpointer, tcount,
-			    tstatus);
-			comm.send_batch(batching.b[overseer], overseer);
-			comm.satisfied_runlow(overseer);
+			//check_batch_finished(child);
+			int size = batches::batch_size(comm.requested_size(child), taskpointer, tcount,
+						       children.size());
+			batching.compose_batch(child, taskpointer, tcount,
+			    tstatus, size);
+			comm.send_batch(batching.b[child], child);
+			comm.satisfied_runlow(child);
+		    }
+		}
+
+		if (PRUNED_PROPAGATION)
+		{
+		    std::vector<int> pruned = take_pruned_pending();
+		    if (!pruned.empty())
+		    {
+			if (USING_RMA_TSTATUS)
+			{
+			    comm.rma_publish_pruned(pruned, round);
+			} else
+			{
+			    comm.send_pruned_tasks(pruned, round);
+			}
 		    }
 		}
 
 		// comm.compose_and_send_batches(); // send_out_batches();
-		std::this_thread::sleep_for(std::chrono::milliseconds(TICK_SLEEP));
+		// Messages from the overseers are only polled; we wake up early when the updater ends.
+		queen_event.wait_since(updater_epoch);
 	    }
 
 	    // suspend updater thread
 	    x.join();
+	    take_pruned_pending(); // The round is over, the overseers need not know.
 
 	    // Updater_result is no longer POSTPONED; end the round.
 	    // Send ROOT_SOLVED signal to workers that wait for tasks and those
 	    // that process tasks.
 	    comm.send_root_solved();
-	    // collect remaining, unnecessary solutions
+	    if (USING_RMA_TSTATUS)
+	    {
+		comm.rma_close_window();
+	    }
+	    comm.sync_after_round_end();
+	    if (TASK_STORE)
+	    {
+		task_store.record();
+		task_store.save();
+	    }
+	    if (TASK_COST_ORDERING)
+	    {
+		comm.collect_task_timings(timings.pending, round);
+		timings.record_round(cost_model);
+	    }
+	    // The arrays are only destroyed once the overseers are done with the round,
+	    // as in the local mode they still use them until then.
 	    destroy_tarray();
 	    destroy_tstatus();
-	    comm.sync_after_round_end();
+	    // collect remaining, unnecessary solutions
 	    comm.ignore_additional_solutions();
 	}
 	// --- END PARALLEL PHASE ---
@@ -409,14 +737,29 @@ int queen_class::start()
 	perf_timer.parallel_phase_end();
 	perf_timer.new_sapling_end(job);
 
-	job.mark_complete();
-	if (job.root->win == victory::adv)
+	// The round ends as soon as the algorithm wins one of the saplings, and the others
+	// may stay uncertain, so only a sapling won by the algorithm is the losing one.
+	for (sapling& j : round_jobs)
+	{
+	    j.mark_complete();
+	    if (j.root->win == victory::alg && losing_root == nullptr)
+	    {
+		losing_root = j.root;
+	    }
+	}
+
+	if (losing_root == nullptr)
 	{
-	    winning_saplings++;
+	    for (const sapling& j : round_jobs)
+	    {
+		assert(j.root->win == victory::adv);
+	    }
+
+	    winning_saplings += round_jobs.size();
 	    cleanup_after_adv_win(qdag, job.evaluation); // Cleanup also prunes winning saplings.
 	} else
 	{
-	    losing_binconf = job.root->bc;
+	    losing_binconf = losing_root->bc;
 	    ret = 1;
 	    break;
 	}
@@ -461,6 +804,23 @@ int queen_class::start()
     }
 
     // --- End of the whole evaluation loop. ---
+    pipeline.discard();
+    if (CHECKPOINTING && !ESTIMATING)
+    {
+	checkpointer.remove();
+    }
+
+    if (SAPLING_PIPELINING)
+    {
+	print_if<PROGRESS>("Queen: %d saplings were generated speculatively, %d of them in vain.\n",
+			   pipeline.grafted + pipeline.discarded, pipeline.discarded);
+    }
+
+    if (USING_MINIBINSTRETCHING && mbs != nullptr)
+    {
+	delete mbs;
+	mbs = nullptr;
+    }
     
     // We are terminating, start final round.
     print_if<COMM_DEBUG>("Queen: starting final round.\n");
@@ -468,8 +828,13 @@ int queen_class::start()
     comm.receive_measurements();
     comm.sync_after_round_end();
 
+    if (ESTIMATING)
+    {
+	estimator.print_summary(stdout, ESTIMATE_WORKERS);
+    }
+
     // Global post-evaluation checks belong here.
-    if (ret == 0)
+    if (ret == 0 && !ESTIMATING)
     {
 	// One final update run should establish that the root is winning.
 	updater_computation ucomp_root(qdag);
@@ -482,7 +847,7 @@ int queen_class::start()
     perf_timer.queen_end();
 
     // Print the treetop of the tree (with tasks offloaded) for logging purposes.
-    if (ret != 1)
+    if (ret != 1 && !ESTIMATING)
     {
         std::time_t t = std::time(0);   // Get time now.
 	std::tm* now = std::localtime(&t);
@@ -490,7 +855,7 @@ int queen_class::start()
     }
     
     // We now print the full output only once, after a full tree is generated.
-    if (OUTPUT)
+    if (OUTPUT && !ESTIMATING)
     {
 	savefile(qdag, qdag->root);
     }
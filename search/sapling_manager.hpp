@@ -10,6 +10,7 @@ private:
     int regrow_threshold = 0;
     dag *d = nullptr;
     sapling first_found_job;
+    std::vector<adversary_vertex*> skipped_roots;
     
     void find_uncertain_sapling_adv(adversary_vertex *v);
     void find_uncertain_sapling_alg(algorithm_vertex *v);
@@ -26,6 +27,7 @@ public:
     sapling find_sapling();
     sapling find_first_uncertain();
     sapling find_first_unexpanded();
+    sapling find_next_uncertain(const std::vector<adversary_vertex*>& in_progress);
     uint64_t count_saplings();
 };
 
@@ -39,6 +41,12 @@ void sapling_manager::find_uncertain_sapling_adv(adversary_vertex *adv_v)
 
     adv_v->visited = true;
 
+    // The saplings in progress are treated as if they were already winning.
+    if (std::find(skipped_roots.begin(), skipped_roots.end(), adv_v) != skipped_roots.end())
+    {
+	return;
+    }
+
     if (adv_v->sapling && adv_v->win == victory::uncertain)
     {
 	first_found_job.evaluation = true;
@@ -97,6 +105,16 @@ sapling sapling_manager::find_first_uncertain()
     return first_found_job;
 }
 
+// Finds the sapling which find_first_uncertain() is going to return once the saplings
+// in progress are won. Only a guess, as their evaluation may prune it.
+sapling sapling_manager::find_next_uncertain(const std::vector<adversary_vertex*>& in_progress)
+{
+    skipped_roots = in_progress;
+    sapling next = find_first_uncertain();
+    skipped_roots.clear();
+    return next;
+}
+
 void sapling_manager::find_unexpanded_sapling_adv(adversary_vertex *adv_v)
 {
     if (adv_v->visited)
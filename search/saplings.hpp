@@ -1,6 +1,8 @@
 #ifndef _SAPLINGS_HPP
 #define _SAPLINGS_HPP 1
 
+#include <optional>
+
 #include "dag/dag.hpp"
 
 // Helper functions on the DAG which have to do with saplings.
@@ -19,6 +21,7 @@ public:
     uint64_t binconf_hash; // binconf hash for debug purposes
     bool expansion = false;
     bool evaluation = true;
+    std::optional<task_bounds> tuned_bounds; // Set by the autotuner, if it is enabled.
 
     void mark_in_progress()
 	{
@@ -45,6 +48,19 @@ public:
 	    }
 	}
 
+    // The task bounds for generating the sapling; they grow with the regrow level.
+    task_bounds bounds() const
+	{
+	    if (tuned_bounds.has_value())
+	    {
+		return tuned_bounds.value();
+	    }
+
+	    return task_bounds{TASK_DEPTH_INIT + regrow_level * TASK_DEPTH_STEP,
+			       TASK_LOAD_INIT + regrow_level * TASK_LOAD_STEP,
+			       root->bc.totalload()};
+	}
+
     void print_sapling(FILE* stream)
 	{
 	    if (evaluation)
@@ -0,0 +1,230 @@
+#ifndef _SUBQUEEN_HPP
+#define _SUBQUEEN_HPP 1
+
+#include <deque>
+#include <chrono>
+#include <thread>
+
+#include "common.hpp"
+#include "measure_structures.hpp"
+#include "tasks.hpp"
+
+// A sub-queen stands between the queen and a group of up to SUBQUEEN_FANOUT overseers
+// (see multiprocess::parent()). It asks the queen for large batches, which form its slice
+// of the task queue, and hands the slice out to its overseers in the batch sizes they
+// request. In the other direction, it collects the solutions of the whole group, drops
+// those of tasks which the queen has pruned in the meantime, and forwards the rest in full
+// messages. This way, the queen handles one message where it would otherwise handle
+// up to SUBQUEEN_FANOUT of them.
+
+// The sub-queen takes part in all collective operations as an overseer without workers.
+
+class subqueen
+{
+public:
+    std::vector<int> children;
+
+    // Tasks received from the queen and not yet handed out.
+    std::deque<int> slice;
+    bool slice_requested = false;
+    bool queue_drained = false; // The queen has no more tasks.
+    int round = 0; // Counted the same way as on the queen, for the pruning messages.
+    std::array<int, MAX_BATCH_SIZE> upcoming_batch;
+
+    // Solutions of the group waiting to be forwarded, as (task id, status) pairs.
+    std::vector<int> pending_solutions;
+    std::chrono::time_point<std::chrono::steady_clock> oldest_pending_solution;
+
+    void start();
+    void receive_slice();
+    void serve_runlows();
+    void forward_pruned();
+    void forward_solutions();
+    void forward_task_timings();
+};
+
+// Keeps at least half of a maximum batch in the slice, as long as the queen has tasks.
+// The last group may consist of the sub-queen only, which then takes no tasks at all.
+void subqueen::receive_slice()
+{
+    if (!children.empty() && !slice_requested && !queue_drained && slice.size() < MAX_BATCH_SIZE / 2)
+    {
+	comm.request_new_batch(MAX_BATCH_SIZE);
+	slice_requested = true;
+    }
+
+    if (slice_requested)
+    {
+	int received = comm.try_receiving_batch(upcoming_batch);
+	if (received > 0)
+	{
+	    slice_requested = false;
+	    for (int i = 0; i < received; i++)
+	    {
+		if (upcoming_batch[i] == NO_MORE_TASKS)
+		{
+		    queue_drained = true;
+		} else
+		{
+		    slice.push_back(upcoming_batch[i]);
+		}
+	    }
+	}
+    }
+}
+
+// Answers the overseers which are running low. Once the queen has no more tasks and the slice
+// is empty, the batches are padded with NO_MORE_TASKS, exactly as the queen would do it.
+void subqueen::serve_runlows()
+{
+    comm.collect_runlows();
+    for (int child : children)
+    {
+	if (!comm.is_running_low(child))
+	{
+	    continue;
+	}
+
+	int size = comm.requested_size(child);
+	std::vector<int> batch;
+	while ((int) batch.size() < size && !slice.empty())
+	{
+	    int task_id = slice.front();
+	    slice.pop_front();
+	    if (tstatus[task_id].load(std::memory_order_acquire) == task_status::available)
+	    {
+		batch.push_back(task_id);
+	    }
+	}
+
+	if (slice.empty() && queue_drained)
+	{
+	    batch.resize(size, NO_MORE_TASKS);
+	} else if (batch.empty())
+	{
+	    // The request stays open until the queen sends more tasks.
+	    continue;
+	}
+
+	comm.send_batch(batch, child);
+	comm.satisfied_runlow(child);
+    }
+}
+
+void subqueen::forward_pruned()
+{
+    std::vector<int> pruned;
+    comm.receive_pruned_tasks(tstatus, round, &pruned);
+    if (!pruned.empty())
+    {
+	comm.send_pruned_tasks(pruned, round);
+    }
+}
+
+void subqueen::forward_solutions()
+{
+    std::vector<int> incoming;
+    if (comm.collect_solutions(incoming))
+    {
+	for (unsigned int p = 0; p + 1 < incoming.size(); p += 2)
+	{
+	    // The queen does not need the results of the tasks it has already pruned.
+	    if (tstatus[incoming[p]].load(std::memory_order_acquire) == task_status::pruned)
+	    {
+		continue;
+	    }
+
+	    tstatus[incoming[p]].store(static_cast<task_status>(incoming[p+1]), std::memory_order_release);
+	    if (pending_solutions.empty())
+	    {
+		oldest_pending_solution = std::chrono::steady_clock::now();
+	    }
+	    pending_solutions.push_back(incoming[p]);
+	    pending_solutions.push_back(incoming[p+1]);
+	}
+    }
+
+    if (pending_solutions.empty())
+    {
+	return;
+    }
+
+    std::chrono::duration<double, std::milli> waiting = std::chrono::steady_clock::now() - oldest_pending_solution;
+    if (pending_solutions.size() >= 2*SOLUTION_BATCH_SIZE || waiting.count() >= SOLUTION_FLUSH_MS)
+    {
+	for (unsigned int start = 0; start < pending_solutions.size(); start += 2*SOLUTION_BATCH_SIZE)
+	{
+	    unsigned int end = std::min(start + 2*SOLUTION_BATCH_SIZE, (unsigned int) pending_solutions.size());
+	    comm.send_solutions(std::vector<int>(pending_solutions.begin() + start, pending_solutions.begin() + end));
+	}
+	pending_solutions.clear();
+    }
+}
+
+// The timings are only statistics, so they are passed on at once, without any batching.
+void subqueen::forward_task_timings()
+{
+    std::vector<int> incoming;
+    if (comm.collect_task_timings(incoming, round))
+    {
+	for (unsigned int start = 0; start < incoming.size(); start += 2*SOLUTION_BATCH_SIZE)
+	{
+	    unsigned int end = std::min(start + 2*SOLUTION_BATCH_SIZE, (unsigned int) incoming.size());
+	    comm.send_task_timings(std::vector<int>(incoming.begin() + start, incoming.begin() + end), round);
+	}
+    }
+}
+
+void subqueen::start()
+{
+    comm.deferred_construction();
+    children = multiprocess::children();
+    print_if<PROGRESS>("Sub-queen %d: serving %zu overseers.\n", multiprocess::world_rank, children.size());
+
+    comm.bcast_recv_and_assign_zobrist();
+    comm.send_number_of_workers(0);
+    comm.learn_worker_rank();
+    comm.sync_after_initialization();
+
+    std::vector<worker_flags*> no_workers;
+    while (true)
+    {
+	bool final_round = comm.round_start_and_finality();
+	if (final_round)
+	{
+	    comm.transmit_measurements(ov_meas);
+	    comm.sync_after_round_end();
+	    break;
+	}
+
+	round++;
+	receive_tarray_tstatus();
+	slice.clear();
+	slice_requested = false;
+	queue_drained = false;
+	comm.reset_runlows();
+
+	while (!comm.check_root_solved(no_workers))
+	{
+	    forward_pruned();
+	    forward_solutions();
+	    forward_task_timings();
+	    receive_slice();
+	    serve_runlows();
+	    // There are no workers to wait for, so we only poll.
+	    std::this_thread::sleep_for(std::chrono::milliseconds(SOLUTION_FLUSH_MS));
+	}
+
+	// Passing the signal on only now guarantees that it arrives after our last batch.
+	comm.send_root_solved();
+	comm.ignore_additional_signals();
+	pending_solutions.clear();
+	destroy_tarray();
+	destroy_tstatus();
+	comm.sync_after_round_end();
+	// Drop what the overseers sent before they learned about the end of the round.
+	comm.ignore_additional_solutions();
+    }
+}
+
+#endif // _SUBQUEEN_HPP
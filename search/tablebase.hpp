@@ -0,0 +1,411 @@
+#ifndef _TABLEBASE_HPP
+#define _TABLEBASE_HPP 1
+
+// An endgame tablebase: all adversary positions with remaining volume
+// (S*BINS minus the total load) at most a given bound, solved by retrograde analysis.
+
+// A position of the adversary is given by the loads, the items and the lowest
+// item the adversary can still send. The adversary wins with the lowest sendable
+// item l if and only if it has a winning item of size at least l. Thus, for each pair
+// (loads, items) we only store the largest winning item of the adversary
+// (zero if there is none), and the result for any l follows from one probe.
+// Only the pairs which can arise in the game are stored: the items must fit into
+// the optimum, and they must also be packable into bins with exactly these loads.
+
+// The table is built offline (minitools/tablebase.cpp) level by level, in the order
+// of decreasing total load, as every move of the game increases the total load.
+// Each level is split among threads. The result is stored in ./cache/ in the same
+// manner as the minibinstretching tables (see binary_storage.hpp).
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+
+#include "common.hpp"
+#include "functions.hpp"
+#include "hash.hpp"
+#include "binconf.hpp"
+
+class endgame_tablebase
+{
+public:
+    static constexpr int VERSION = 1;
+    static constexpr int KMAX_BITS = 10;
+    static constexpr uint64_t KMAX_MASK = (1ULL << KMAX_BITS) - 1;
+    static_assert(S <= KMAX_MASK);
+
+    int volume = 0;
+    char storage_file_path[256];
+
+    // The compact table: open addressing with linear probing, each element holds
+    // the upper bits of loaditemhash() and the largest winning item in the lowest bits.
+    std::vector<uint64_t> table;
+    int logsize = 0;
+
+    // Results during the build, indexed by loaditemhash().
+    std::unordered_map<uint64_t, bin_int> solved;
+
+    // A feasible item multiset with all load vectors (below R) into which it can be packed.
+    struct itemset_positions
+    {
+	std::array<bin_int, S+1> items;
+	std::vector<std::array<bin_int, BINS+1>> loadvecs;
+    };
+
+    // Feasible item multisets grouped by their total size, starting from lowest_total().
+    std::vector<std::vector<itemset_positions>> itemsets_by_total;
+    // The item hashes of all feasible multisets, including those with no load vector.
+    std::unordered_set<uint64_t> feasible_itemhashes;
+    uint64_t position_count = 0;
+
+    endgame_tablebase(int vol) : volume(vol)
+	{
+	    sprintf(storage_file_path, "./cache/tablebase-%d-%d-%d-mon-%d-vol-%d.bin", BINS, R, S, monotonicity, volume);
+	}
+
+    // The smallest total load of a position in the table.
+    int lowest_total() const
+	{
+	    return std::max(0, S*BINS - volume);
+	}
+
+    // --- Querying. ---
+
+    bool covers(const binconf &b) const
+	{
+	    return S*BINS - b.totalload() <= volume;
+	}
+
+    // Returns victory::uncertain if the position is not in the table.
+    victory probe(const binconf &b) const
+	{
+	    uint64_t h = b.loaditemhash();
+	    uint64_t pos = logpart(h, logsize);
+	    for (uint64_t i = pos; i < std::min(table.size(), pos + LINPROBE_LIMIT); i++)
+	    {
+		if (table[i] == 0)
+		{
+		    break;
+		}
+
+		if ((table[i] & ~KMAX_MASK) == (h & ~KMAX_MASK))
+		{
+		    bin_int largest_winning = table[i] & KMAX_MASK;
+		    if (largest_winning != 0 && lowest_sendable(b.last_item) <= largest_winning)
+		    {
+			return victory::adv;
+		    } else
+		    {
+			return victory::alg;
+		    }
+		}
+	    }
+
+	    return victory::uncertain;
+	}
+
+    // --- Building. ---
+
+    // Adds one item of the given size to all packings into bins of the given capacity,
+    // keeping them sorted.
+    static std::vector<std::array<bin_int, BINS>> add_to_packings(const std::vector<std::array<bin_int, BINS>> &packings,
+								   int size, int capacity)
+	{
+	    std::set<std::array<bin_int, BINS>> next;
+	    for (const auto &packing : packings)
+	    {
+		for (int i = 0; i < BINS; i++)
+		{
+		    if ((i > 0 && packing[i] == packing[i-1]) || packing[i] + size > capacity)
+		    {
+			continue;
+		    }
+
+		    std::array<bin_int, BINS> extended = packing;
+		    extended[i] += size;
+		    std::sort(extended.begin(), extended.end(), std::greater<bin_int>());
+		    next.insert(extended);
+		}
+	    }
+
+	    return std::vector<std::array<bin_int, BINS>>(next.begin(), next.end());
+	}
+
+    // Enumerates item multisets which fit into BINS bins of capacity S,
+    // going from the largest item size down to the smallest. Along the way, it tracks
+    // the packings of the optimum and the load vectors of the algorithm (loads below R).
+    void enumerate_itemsets(int size, int total, std::array<bin_int, S+1> &items,
+			    const std::vector<std::array<bin_int, BINS>> &packings,
+			    const std::vector<std::array<bin_int, BINS>> &alg_packings)
+	{
+	    if (size == 0)
+	    {
+		if (total >= lowest_total())
+		{
+		    if (!alg_packings.empty())
+		    {
+			itemset_positions positions;
+			positions.items = items;
+			for (const auto &packing : alg_packings)
+			{
+			    std::array<bin_int, BINS+1> loadvec = {};
+			    std::copy(packing.begin(), packing.end(), loadvec.begin() + 1);
+			    positions.loadvecs.push_back(loadvec);
+			}
+			position_count += positions.loadvecs.size();
+			itemsets_by_total[total - lowest_total()].push_back(positions);
+		    }
+
+		    uint64_t itemhash = 0;
+		    for (int j = 1; j <= S; j++)
+		    {
+			itemhash ^= Zi[j*(MAX_ITEMS+1) + items[j]];
+		    }
+		    feasible_itemhashes.insert(itemhash);
+		}
+		return;
+	    }
+
+	    enumerate_itemsets(size - 1, total, items, packings, alg_packings);
+
+	    std::vector<std::array<bin_int, BINS>> current = packings;
+	    std::vector<std::array<bin_int, BINS>> alg_current = alg_packings;
+	    for (int count = 1; total + count*size <= S*BINS; count++)
+	    {
+		current = add_to_packings(current, size, S);
+		if (current.empty())
+		{
+		    break;
+		}
+		// The multiset stays feasible for the optimum even if the algorithm cannot pack it.
+		alg_current = add_to_packings(alg_current, size, R-1);
+		items[size] = count;
+		enumerate_itemsets(size - 1, total + count*size, items, current, alg_current);
+	    }
+	    items[size] = 0;
+	}
+
+    // The largest item with which the adversary wins, zero if there is none.
+    // All positions with a larger total load must already be solved.
+    bin_int largest_winning_item(binconf &b) const
+	{
+	    for (int item = std::min(S, S*BINS - b.totalload()); item >= 1; item--)
+	    {
+		if (!itemset_feasible(b, item))
+		{
+		    continue;
+		}
+
+		uint64_t next_itemhash = b.itemhash ^ Zi[item*(MAX_ITEMS+1) + b.items[item]]
+		    ^ Zi[item*(MAX_ITEMS+1) + b.items[item] + 1];
+		bool adv_wins = true;
+
+		for (int bin = 1; bin <= BINS; bin++)
+		{
+		    if (bin > 1 && b.loads[bin] == b.loads[bin-1])
+		    {
+			continue;
+		    }
+
+		    if (b.loads[bin] + item >= R)
+		    {
+			continue;
+		    }
+
+		    auto it = solved.find(b.virtual_loadhash(item, bin) ^ next_itemhash);
+		    if (it == solved.end() || it->second == 0 || lowest_sendable(item) > it->second)
+		    {
+			adv_wins = false;
+			break;
+		    }
+		}
+
+		if (adv_wins)
+		{
+		    return item;
+		}
+	    }
+
+	    return 0;
+	}
+
+    // Checks whether the items of b together with item fit into the optimum.
+    bool itemset_feasible(const binconf &b, int item) const
+	{
+	    if (b.totalload() + item > S*BINS)
+	    {
+		return false;
+	    }
+
+	    uint64_t next_itemhash = b.itemhash ^ Zi[item*(MAX_ITEMS+1) + b.items[item]]
+		^ Zi[item*(MAX_ITEMS+1) + b.items[item] + 1];
+	    return feasible_itemhashes.contains(next_itemhash);
+	}
+
+    void solve_segment(int total, uint64_t start, uint64_t end, std::vector<std::pair<uint64_t, bin_int>> *out) const
+	{
+	    const auto &sets = itemsets_by_total[total - lowest_total()];
+	    binconf b;
+	    for (uint64_t s = start; s < std::min(end, (uint64_t) sets.size()); s++)
+	    {
+		for (const auto &loadvec : sets[s].loadvecs)
+		{
+		    b.blank();
+		    b.loads = loadvec;
+		    b.items = sets[s].items;
+		    b.hash_loads_init();
+		    out->push_back(std::make_pair(b.loaditemhash(), largest_winning_item(b)));
+		}
+	    }
+	}
+
+    void build(int threads)
+	{
+	    int levels = S*BINS - lowest_total() + 1;
+	    itemsets_by_total.assign(levels, {});
+
+	    std::array<bin_int, S+1> items = {};
+	    std::vector<std::array<bin_int, BINS>> empty_packing(1, std::array<bin_int, BINS>{});
+	    enumerate_itemsets(S, 0, items, empty_packing, empty_packing);
+	    print_if<PROGRESS>("Tablebase: %zu feasible item sets, %" PRIu64 " positions to solve.\n",
+			       feasible_itemhashes.size(), position_count);
+
+	    for (int total = S*BINS; total >= lowest_total(); total--)
+	    {
+		uint64_t set_count = itemsets_by_total[total - lowest_total()].size();
+		uint64_t segment = set_count / threads + 1;
+		std::vector<std::vector<std::pair<uint64_t, bin_int>>> results(threads);
+		std::vector<std::thread> th;
+		for (int w = 0; w < threads; w++)
+		{
+		    th.push_back(std::thread(&endgame_tablebase::solve_segment, this, total,
+					     w * segment, (w+1) * segment, &results[w]));
+		}
+
+		for (int w = 0; w < threads; w++)
+		{
+		    th[w].join();
+		    for (const auto &[hash, largest_winning] : results[w])
+		    {
+			solved[hash] = largest_winning;
+		    }
+		}
+
+		print_if<PROGRESS>("Tablebase: level with total load %d solved, %" PRIu64 " item sets, %zu positions so far.\n",
+				   total, set_count, solved.size());
+	    }
+
+	    compact();
+	}
+
+    // Moves the results of the build into the compact table.
+    void compact()
+	{
+	    uint64_t tsize = power_of_two_below(std::max((uint64_t) 2, (uint64_t) solved.size())) * 4;
+	    logsize = quicklog(tsize);
+	    table.assign(tsize, 0);
+
+	    uint64_t dropped = 0;
+	    for (const auto &[hash, largest_winning] : solved)
+	    {
+		uint64_t pos = logpart(hash, logsize);
+		bool stored = false;
+		for (uint64_t i = pos; i < std::min(tsize, pos + LINPROBE_LIMIT); i++)
+		{
+		    if (table[i] == 0)
+		    {
+			// An element is never zero, as the hash bits are zero with negligible probability.
+			table[i] = (hash & ~KMAX_MASK) | largest_winning;
+			stored = true;
+			break;
+		    }
+		}
+
+		if (!stored)
+		{
+		    dropped++;
+		}
+	    }
+
+	    print_if<PROGRESS>("Tablebase: %zu positions in a table of %" PRIu64 " elements, %" PRIu64 " dropped.\n",
+			       solved.size(), tsize, dropped);
+	    solved.clear();
+	    feasible_itemhashes.clear();
+	    itemsets_by_total.clear();
+	}
+
+    // --- Storage. ---
+
+    bool storage_exists()
+	{
+	    return std::filesystem::exists(storage_file_path);
+	}
+
+    void backup()
+	{
+	    FILE *storage_file = fopen(storage_file_path, "wb");
+	    assert(storage_file != nullptr);
+
+	    int signature[6] = {BINS, R, S, monotonicity, volume, VERSION};
+	    fwrite(signature, sizeof(int), 6, storage_file);
+	    fwrite(Zi, sizeof(uint64_t), ZI_SIZE, storage_file);
+	    fwrite(Zl, sizeof(uint64_t), ZL_SIZE, storage_file);
+	    uint64_t tsize = table.size();
+	    fwrite(&tsize, sizeof(uint64_t), 1, storage_file);
+	    fwrite(table.data(), sizeof(uint64_t), tsize, storage_file);
+	    fclose(storage_file);
+	}
+
+    // Returns false if the stored table does not match the current build.
+    bool restore()
+	{
+	    FILE *storage_file = fopen(storage_file_path, "rb");
+	    assert(storage_file != nullptr);
+
+	    int signature[6] = {};
+	    int expected_signature[6] = {BINS, R, S, monotonicity, volume, VERSION};
+	    bool ret = (fread(signature, sizeof(int), 6, storage_file) == 6)
+		&& std::equal(signature, signature + 6, expected_signature);
+
+	    if (ret)
+	    {
+		std::vector<uint64_t> read_zi(ZI_SIZE), read_zl(ZL_SIZE);
+		ret = fread(read_zi.data(), sizeof(uint64_t), ZI_SIZE, storage_file) == (size_t) ZI_SIZE
+		    && fread(read_zl.data(), sizeof(uint64_t), ZL_SIZE, storage_file) == (size_t) ZL_SIZE
+		    && std::equal(read_zi.begin(), read_zi.end(), Zi)
+		    && std::equal(read_zl.begin(), read_zl.end(), Zl);
+	    }
+
+	    uint64_t tsize = 0;
+	    if (ret)
+	    {
+		ret = fread(&tsize, sizeof(uint64_t), 1, storage_file) == 1;
+	    }
+
+	    if (ret)
+	    {
+		table.assign(tsize, 0);
+		logsize = quicklog(tsize);
+		ret = fread(table.data(), sizeof(uint64_t), tsize, storage_file) == tsize;
+	    }
+
+	    fclose(storage_file);
+
+	    if (!ret)
+	    {
+		fprintf(stderr, "Reading the endgame tablebase %s: signature or data verification failed.\n", storage_file_path);
+		table.clear();
+	    }
+
+	    return ret;
+	}
+};
+
+// Global pointer to the tablebase, shared by all workers of an overseer.
+endgame_tablebase *tb = nullptr;
+
+#endif // _TABLEBASE_HPP
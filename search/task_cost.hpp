@@ -0,0 +1,261 @@
+#ifndef _TASK_COST_HPP
+#define _TASK_COST_HPP 1
+
+// A predictor of the running time of a task, used by the queen to order the task queue.
+
+// The overseers report the processing time of each solved task to the queen, next to the
+// solutions. The queen fits a linear model of the logarithm of the processing time by least
+// squares and, if enough data is available, sorts the tasks so that the most expensive ones
+// go first. This shortens the tail of a round, when only a few long tasks remain.
+
+// After each round, the queen adds the new samples to the model and appends them to a
+// machine-readable file in LOG_DIR, one line per task: the processing time followed by
+// the features of the task. On startup, the model is trained on this file. Once the file
+// has TASKLOG_MAX_LINES lines, it replaces the previous ".old" file and a new one is started,
+// so that only the recent samples are kept and read.
+
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "binconf.hpp"
+#include "tasks.hpp"
+
+const std::string TASKLOG_FILENAME = LOG_DIR + "/tasklog-" + std::to_string(BINS) + "-"
+    + std::to_string(R) + "-" + std::to_string(S) + "-mon-" + std::to_string(monotonicity) + ".txt";
+const std::string TASKLOG_OLD_FILENAME = TASKLOG_FILENAME + ".old";
+constexpr int TASKLOG_MAX_LINES = 100000;
+
+class task_cost_model
+{
+public:
+    // The constant term, the largest load, the number of items, the largest item,
+    // the remaining volume, the lowest sendable item and the expansion depth.
+    static constexpr int FEATURES = 7;
+    static constexpr int MIN_SAMPLES = 10 * FEATURES;
+    // A small ridge term keeps the normal equations solvable when a feature is constant.
+    static constexpr double RIDGE = 1e-6;
+
+    std::array<double, FEATURES> coefs = {};
+    bool trained = false;
+
+    // Normal equations (X^T X) c = X^T y of all samples so far.
+    std::array<std::array<double, FEATURES+1>, FEATURES> normal = {};
+    int samples = 0;
+
+    static std::array<double, FEATURES> features(const task &t)
+	{
+	    int largest_item = 0;
+	    for (int i = S; i >= 1; i--)
+	    {
+		if (t.bc.items[i] > 0)
+		{
+		    largest_item = i;
+		    break;
+		}
+	    }
+
+	    return {1.0, (double) t.bc.loads[1], (double) t.bc._itemcount, (double) largest_item,
+		    (double) (S*BINS - t.bc._totalload), (double) lowest_sendable(t.bc.last_item),
+		    (double) t.expansion_depth};
+	}
+
+    double predict(const task &t) const
+	{
+	    std::array<double, FEATURES> x = features(t);
+	    double ret = 0.0;
+	    for (int i = 0; i < FEATURES; i++)
+	    {
+		ret += coefs[i] * x[i];
+	    }
+	    return ret;
+	}
+
+    void add_sample(const std::array<double, FEATURES> &x, long double seconds)
+	{
+	    double y = std::log(1e-4 + (double) seconds);
+	    for (int i = 0; i < FEATURES; i++)
+	    {
+		for (int j = 0; j < FEATURES; j++)
+		{
+		    normal[i][j] += x[i] * x[j];
+		}
+		normal[i][FEATURES] += x[i] * y;
+	    }
+	    samples++;
+	}
+
+    // Solves the normal equations. Returns false if there is not enough data.
+    bool fit()
+	{
+	    if (samples < MIN_SAMPLES)
+	    {
+		return false;
+	    }
+
+	    std::array<std::array<double, FEATURES+1>, FEATURES> system = normal;
+	    for (int i = 0; i < FEATURES; i++)
+	    {
+		system[i][i] += RIDGE * samples;
+	    }
+
+	    // Gaussian elimination with partial pivoting.
+	    for (int col = 0; col < FEATURES; col++)
+	    {
+		int pivot = col;
+		for (int row = col + 1; row < FEATURES; row++)
+		{
+		    if (std::fabs(system[row][col]) > std::fabs(system[pivot][col]))
+		    {
+			pivot = row;
+		    }
+		}
+		std::swap(system[col], system[pivot]);
+
+		for (int row = 0; row < FEATURES; row++)
+		{
+		    if (row != col)
+		    {
+			double factor = system[row][col] / system[col][col];
+			for (int k = col; k <= FEATURES; k++)
+			{
+			    system[row][k] -= factor * system[col][k];
+			}
+		    }
+		}
+	    }
+
+	    for (int i = 0; i < FEATURES; i++)
+	    {
+		coefs[i] = system[i][FEATURES] / system[i][i];
+	    }
+
+	    trained = true;
+	    return true;
+	}
+
+    // Adds the samples of one task log file, if it exists.
+    void read_samples(const std::string &filename)
+	{
+	    FILE *fin = fopen(filename.c_str(), "r");
+	    if (fin == nullptr)
+	    {
+		return;
+	    }
+
+	    long double seconds = 0;
+	    std::array<int, FEATURES-1> read = {};
+	    while (fscanf(fin, "%Lf %d %d %d %d %d %d", &seconds, &read[0], &read[1], &read[2],
+			  &read[3], &read[4], &read[5]) == FEATURES)
+	    {
+		std::array<double, FEATURES> x = {1.0};
+		for (int i = 1; i < FEATURES; i++)
+		{
+		    x[i] = read[i-1];
+		}
+		add_sample(x, seconds);
+	    }
+	    fclose(fin);
+	}
+
+    // Fits the model to the samples in the task log and the previous one.
+    // Returns false if there is not enough data.
+    bool train()
+	{
+	    read_samples(TASKLOG_OLD_FILENAME);
+	    read_samples(TASKLOG_FILENAME);
+	    if (!fit())
+	    {
+		return false;
+	    }
+
+	    print_if<PROGRESS>("Task cost model trained on %d samples from %s.\n", samples, TASKLOG_FILENAME.c_str());
+	    return true;
+	}
+};
+
+// The processing times reported to the queen during a round, as (task id, milliseconds) pairs.
+class task_timings
+{
+public:
+    std::vector<int> pending;
+    // The number of lines in the task log, counted on the first write.
+    int logged_lines = -1;
+
+    static int count_lines(const std::string &filename)
+	{
+	    FILE *fin = fopen(filename.c_str(), "r");
+	    if (fin == nullptr)
+	    {
+		return 0;
+	    }
+
+	    int lines = 0;
+	    int c = 0;
+	    while ((c = fgetc(fin)) != EOF)
+	    {
+		lines += (c == '\n') ? 1 : 0;
+	    }
+	    fclose(fin);
+	    return lines;
+	}
+
+    // Adds the reported tasks to the model and to the task log; the task array must be present.
+    void record_round(task_cost_model &model)
+	{
+	    if (pending.empty())
+	    {
+		return;
+	    }
+
+	    std::string lines;
+	    char line[128];
+	    for (unsigned int p = 0; p + 1 < pending.size(); p += 2)
+	    {
+		// The messages of earlier rounds are dropped by the communicator.
+		assert(pending[p] >= 0 && pending[p] < tcount);
+		long double seconds = pending[p+1] / 1000.0L;
+		std::array<double, task_cost_model::FEATURES> x = task_cost_model::features(tarray[pending[p]]);
+		model.add_sample(x, seconds);
+
+		int length = sprintf(line, "%Lf", seconds);
+		for (int i = 1; i < task_cost_model::FEATURES; i++)
+		{
+		    length += sprintf(line + length, " %d", (int) x[i]);
+		}
+		lines.append(line, length);
+		lines.push_back('\n');
+	    }
+
+	    if (logged_lines == -1)
+	    {
+		logged_lines = count_lines(TASKLOG_FILENAME);
+	    }
+
+	    if (logged_lines >= TASKLOG_MAX_LINES)
+	    {
+		std::filesystem::rename(TASKLOG_FILENAME, TASKLOG_OLD_FILENAME);
+		logged_lines = 0;
+	    }
+
+	    // One write per round; only the queen writes the log.
+	    FILE *tasklog_file = fopen(TASKLOG_FILENAME.c_str(), "a");
+	    if (tasklog_file != nullptr)
+	    {
+		fwrite(lines.data(), 1, lines.size(), tasklog_file);
+		fclose(tasklog_file);
+		logged_lines += pending.size() / 2;
+	    }
+
+	    bool was_trained = model.trained;
+	    if (model.fit() && !was_trained)
+	    {
+		print_if<PROGRESS>("Task cost model trained on %d samples.\n", model.samples);
+	    }
+	    pending.clear();
+	}
+};
+
+#endif // _TASK_COST_HPP
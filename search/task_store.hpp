@@ -0,0 +1,189 @@
+#ifndef _TASK_STORE_HPP
+#define _TASK_STORE_HPP 1
+
+// Results of all tasks solved so far, kept by the queen across rounds. The task status
+// array only lives for one round, but the same position may become a task again,
+// in a different sapling, in an expansion or after regrowing.
+
+// Before the tasks of a round are sent out, those with a known result are marked as solved,
+// the same way as the solutions reported by the overseers. The updater then decides the
+// saplings which need no new tasks in its first pass, and the overseers skip these tasks.
+
+// With TASK_STORE_ON_DISK, the results are also appended to a file in ./cache after every
+// round and loaded at the start of the next run. As the positions are stored only by their
+// hashes, the file starts with a fingerprint of the Zobrist keys. The results of a run with
+// assumptions hold only under those assumptions, so such runs neither load nor save the file.
+
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+#include "common.hpp"
+#include "binconf.hpp"
+#include "hash.hpp"
+#include "tasks.hpp"
+#include "assumptions.hpp"
+
+class solved_task_store
+{
+public:
+    static constexpr int VERSION = 1;
+    char file_path[256];
+
+    std::unordered_map<uint64_t, task_status> solved;
+    std::vector<std::pair<uint64_t, task_status>> unsaved;
+
+    solved_task_store()
+	{
+	    sprintf(file_path, "./cache/solved-tasks-%d-%d-%d-mon-%d.bin", BINS, R, S, monotonicity);
+	}
+
+    bool on_disk() const
+	{
+	    return TASK_STORE_ON_DISK && !USING_ASSUMPTIONS;
+	}
+
+    void load();
+    void record();
+    int apply();
+    void save();
+
+    // The file operations themselves, regardless of on_disk().
+    void read_file();
+    void append_to_file();
+
+private:
+    // Changes whenever the Zobrist keys do.
+    static uint64_t fingerprint()
+	{
+	    binconf one_item(std::vector<bin_int>{1}, std::vector<bin_int>{1}, 1);
+	    return one_item.hash_with_last();
+	}
+};
+
+void solved_task_store::load()
+{
+    if (on_disk())
+    {
+	read_file();
+    }
+}
+
+void solved_task_store::read_file()
+{
+    if (!std::filesystem::exists(file_path))
+    {
+	return;
+    }
+
+    FILE *f = fopen(file_path, "rb");
+    assert(f != nullptr);
+    int signature[5] = {};
+    int expected_signature[5] = {BINS, R, S, monotonicity, VERSION};
+    uint64_t keys = 0;
+    if (fread(signature, sizeof(int), 5, f) != 5 || !std::equal(signature, signature + 5, expected_signature)
+	|| fread(&keys, sizeof(uint64_t), 1, f) != 1 || keys != fingerprint())
+    {
+	fprintf(stderr, "Reading the solved tasks %s: signature verification failed, ignoring the file.\n", file_path);
+	fclose(f);
+	return;
+    }
+
+    // A crash while appending may leave an incomplete record at the end. It is skipped
+    // and cut off, so that the records appended later are read correctly.
+    uint64_t hash = 0;
+    task_status status = task_status::available;
+    uintmax_t complete_length = ftell(f);
+    while (fread(&hash, sizeof(uint64_t), 1, f) == 1 && fread(&status, sizeof(task_status), 1, f) == 1)
+    {
+	solved[hash] = status;
+	complete_length += sizeof(uint64_t) + sizeof(task_status);
+    }
+    fclose(f);
+
+    if (std::filesystem::file_size(file_path) > complete_length)
+    {
+	print_if<PROGRESS>("Queen: Cutting off an incomplete record at the end of %s.\n", file_path);
+	std::filesystem::resize_file(file_path, complete_length);
+    }
+
+    print_if<PROGRESS>("Queen: Loaded %zu solved tasks from %s.\n", solved.size(), file_path);
+}
+
+// Remembers the solved tasks of the current round (the task arrays must be present).
+void solved_task_store::record()
+{
+    for (int i = 0; i < tcount; i++)
+    {
+	task_status status = tstatus[i].load(std::memory_order_acquire);
+	if (status == task_status::adv_win || status == task_status::alg_win)
+	{
+	    uint64_t hash = tarray[i].bc.hash_with_last();
+	    if (solved.insert({hash, status}).second)
+	    {
+		unsaved.emplace_back(hash, status);
+	    }
+	}
+    }
+}
+
+// Marks the tasks with a known result as solved. Returns the number of tasks marked.
+int solved_task_store::apply()
+{
+    if (solved.empty())
+    {
+	return 0;
+    }
+
+    std::vector<int> solution_pairs;
+    for (int i = 0; i < tcount; i++)
+    {
+	auto it = solved.find(tarray[i].bc.hash_with_last());
+	if (it != solved.end())
+	{
+	    solution_pairs.push_back(i);
+	    solution_pairs.push_back(static_cast<int>(it->second));
+	}
+    }
+
+    apply_solution_pairs(solution_pairs.data(), solution_pairs.size());
+    print_if<PROGRESS>("Queen: %zu of %d tasks were solved in previous rounds.\n", solution_pairs.size() / 2, tcount);
+    return solution_pairs.size() / 2;
+}
+
+// Appends the results recorded since the last call to the file.
+void solved_task_store::save()
+{
+    if (on_disk() && !unsaved.empty())
+    {
+	append_to_file();
+    }
+    unsaved.clear();
+}
+
+void solved_task_store::append_to_file()
+{
+    bool fresh = !std::filesystem::exists(file_path);
+    FILE *f = fopen(file_path, "ab");
+    assert(f != nullptr);
+    if (fresh)
+    {
+	int signature[5] = {BINS, R, S, monotonicity, VERSION};
+	uint64_t keys = fingerprint();
+	fwrite(signature, sizeof(int), 5, f);
+	fwrite(&keys, sizeof(uint64_t), 1, f);
+    }
+
+    for (const auto& [hash, status] : unsaved)
+    {
+	fwrite(&hash, sizeof(uint64_t), 1, f);
+	fwrite(&status, sizeof(task_status), 1, f);
+    }
+    fclose(f);
+
+    print_if<VERBOSE>("Queen: Appended %zu solved tasks to %s.\n", unsaved.size(), file_path);
+}
+
+#endif // _TASK_STORE_HPP
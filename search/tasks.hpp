@@ -9,6 +9,7 @@ queue update code. */
 #include <algorithm>
 
 #include "common.hpp"
+#include "measure_structures.hpp"
 #include "dag/dag.hpp"
 #include "dfs.hpp"
 // #include "queen.hpp"
@@ -83,7 +84,7 @@ public:
 	    }
 	}
 
-    flat_task flatten()
+    flat_task flatten() const
 	{
 	    flat_task ret;
 	    ret.shorts[0] = bc.last_item;
@@ -113,60 +114,84 @@ public:
 	}
 };
 
-// semi-atomic queue: one pusher, one puller, no resize
-class semiatomic_q
+// Compact serialization of a whole task array, used to broadcast it in bulk.
+// Consecutive tasks tend to share long prefixes of their flat form, so each task is stored
+// as the length of the prefix shared with the previous task, followed by the remaining values,
+// all as variable-length integers. The hashes are not stored; the receiver recomputes them.
+
+constexpr int FLAT_TASK_SHORTS = BINS+S+6;
+
+inline void push_varint(std::vector<uint8_t>& buffer, uint32_t value)
 {
-//private:
-public:
-    int *data = NULL;
-    std::atomic<int> qsize{0};
-    int reserve = 0;
-    std::atomic<int> qhead{0};
-    
-public:
-    ~semiatomic_q()
-       {
-           if(data != NULL)
-           {
-               delete[] data;
-           }
-       }
-
-    void init(const int& r)
-       {
-           data = new int[r];
-           reserve = r;
-       }
-
-
-    void push(const int& n)
-       {
-           assert(qsize < reserve);
-           data[qsize] = n;
-           qsize++;
-       }
-
-    int pop_if_able()
-       {
-           if (qhead >= qsize)
-           {
-               return -1;
-           } else {
-               return data[qhead++];
-           }
-       }
+    while (value >= 0x80)
+    {
+	buffer.push_back((uint8_t) (value | 0x80));
+	value >>= 7;
+    }
+    buffer.push_back((uint8_t) value);
+}
 
-    void clear()
-       {
-           qsize.store(0);
-           qhead.store(0);
-           reserve = 0;
-           delete[] data;
-           data = NULL;
-       }
-};
+inline uint32_t read_varint(const uint8_t *buffer, uint64_t& pos)
+{
+    uint32_t value = 0;
+    int shift = 0;
+    while (buffer[pos] & 0x80)
+    {
+	value |= (uint32_t) (buffer[pos++] & 0x7f) << shift;
+	shift += 7;
+    }
+    value |= (uint32_t) buffer[pos++] << shift;
+    return value;
+}
+
+// Zigzag encoding, so that small negative values (signals) also take one byte.
+inline uint32_t zigzag(int32_t value)
+{
+    return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+}
+
+inline int32_t unzigzag(uint32_t value)
+{
+    return (int32_t) (value >> 1) ^ -((int32_t) (value & 1));
+}
 
+void serialize_tasks(const task *tasks, int count, std::vector<uint8_t>& buffer)
+{
+    flat_task previous = {};
+    for (int t = 0; t < count; t++)
+    {
+	flat_task current = tasks[t].flatten();
+	int prefix = 0;
+	while (prefix < FLAT_TASK_SHORTS && current.shorts[prefix] == previous.shorts[prefix])
+	{
+	    prefix++;
+	}
 
+	push_varint(buffer, prefix);
+	for (int i = prefix; i < FLAT_TASK_SHORTS; i++)
+	{
+	    push_varint(buffer, zigzag(current.shorts[i]));
+	}
+	previous = current;
+    }
+}
+
+void deserialize_tasks(const uint8_t *buffer, task *tasks, int count)
+{
+    flat_task current = {};
+    uint64_t pos = 0;
+    for (int t = 0; t < count; t++)
+    {
+	int prefix = read_varint(buffer, pos);
+	for (int i = prefix; i < FLAT_TASK_SHORTS; i++)
+	{
+	    current.shorts[i] = unzigzag(read_varint(buffer, pos));
+	}
+
+	tasks[t].load(current);
+	tasks[t].bc.hashinit();
+    }
+}
 
 // a queue where one sapling can put its own tasks
 std::queue<sapling> regrow_queue; // This potentially does not work currently.
@@ -177,8 +202,77 @@ std::vector<task_status> tstatus_temporary;
 std::vector<task> tarray_temporary; // temporary array used for building
 task* tarray; // tarray used after we know the size
 
-// Mapping from hashes to status indices.
-std::map<llu, int> tmap;
+// An open-addressing index from state hashes to task ids, with linear probing.
+// The hashes are Zobrist hashes, so their lowest bits serve as the position directly.
+// Task vertices also store their task id directly (adversary_vertex::task_id);
+// the index is only needed when that id is from an earlier round.
+class task_index
+{
+    std::vector<uint64_t> keys;
+    std::vector<int> values; // -1 marks an empty slot.
+    uint64_t mask = 0;
+
+public:
+    void clear()
+	{
+	    keys.clear();
+	    values.clear();
+	    mask = 0;
+	}
+
+    // Builds the index of the given task array, at most half full.
+    void build(const task *tasks, int count)
+	{
+	    uint64_t capacity = 2;
+	    while (capacity < 2 * (uint64_t) count)
+	    {
+		capacity <<= 1;
+	    }
+
+	    keys.assign(capacity, 0);
+	    values.assign(capacity, -1);
+	    mask = capacity - 1;
+
+	    for (int i = 0; i < count; i++)
+	    {
+		uint64_t hash = tasks[i].bc.hash_with_last();
+		uint64_t pos = hash & mask;
+		while (values[pos] != -1)
+		{
+		    pos = (pos + 1) & mask;
+		}
+		keys[pos] = hash;
+		values[pos] = i;
+	    }
+	}
+
+    // Returns the task id, or -1 if there is no task with the given hash.
+    int find(uint64_t hash) const
+	{
+	    if (values.empty())
+	    {
+		return -1;
+	    }
+
+	    uint64_t pos = hash & mask;
+	    while (values[pos] != -1)
+	    {
+		if (keys[pos] == hash)
+		{
+		    return values[pos];
+		}
+		pos = (pos + 1) & mask;
+	    }
+	    return -1;
+	}
+};
+
+task_index tindex;
+
+// The task vertices in the order of collection; only valid until the round starts,
+// as the updater deletes vertices afterwards. Used to renumber the vertices when
+// the task array is reordered.
+std::vector<adversary_vertex*> task_vertices;
 
 
 int tcount = 0;
@@ -236,28 +330,39 @@ void destroy_tstatus()
     // }
 }
 
-// builds an inverse task map after all tasks are inserted into the task array.
-void rebuild_tmap()
+// Builds the index of the task array after all tasks are inserted into it.
+void rebuild_task_index()
 {
-    tmap.clear();
-    for (int i = 0; i < tcount; i++)
+    tindex.build(tarray, tcount);
+}
+
+// After reordering the task array, moves each task vertex to its new position,
+// given by new_position[old position].
+void renumber_task_vertices(const std::vector<int>& new_position)
+{
+    assert(task_vertices.size() == new_position.size());
+    std::vector<adversary_vertex*> renumbered(task_vertices.size());
+    for (unsigned int i = 0; i < task_vertices.size(); i++)
     {
-	tmap.insert(std::make_pair(tarray[i].bc.hash_with_last(), i));
+	renumbered[new_position[i]] = task_vertices[i];
+	task_vertices[i]->task_id = new_position[i];
     }
-   
+    task_vertices.swap(renumbered);
 }
 
-// returns the task map value or -1 if it doesn't exist
+// returns the task id of the vertex or -1 if it is not a task of the current round
 int tstatus_id(const adversary_vertex *v)
 {
     if (v == NULL) { return -1; }
 
-    if (tmap.find(v->bc.hash_with_last()) != tmap.end())
+    uint64_t hash = v->bc.hash_with_last();
+    if (v->task_id >= 0 && v->task_id < tcount && tarray != NULL
+	&& tarray[v->task_id].bc.hash_with_last() == hash)
     {
-	return tmap[v->bc.hash_with_last()];
+	return v->task_id;
     }
-	
-    return -1;
+
+    return tindex.find(hash);
 }
 
 // Printing the full task queue for analysis/debugging purposes.
@@ -270,7 +375,7 @@ void print_tasks()
     }
 }
 
-// permutes tarray and tstatus (with the same permutation), rebuilds tmap.
+// permutes tarray and tstatus (with the same permutation), rebuilds the task index.
 void permute_tarray_tstatus()
 {
     assert(tcount > 0);
@@ -296,10 +401,11 @@ void permute_tarray_tstatus()
     tarray = tarray_new;
     tstatus = tstatus_new;
 
-    rebuild_tmap();
+    renumber_task_vertices(perm);
+    rebuild_task_index();
 }
 
-// Reverses tarray and tstatus, rebuilds tmap.
+// Reverses tarray and tstatus, rebuilds the task index.
 // The code is a bit wonky, as we just modify permute_tarray_tstatus().
 void reverse_tarray_tstatus()
 {
@@ -324,22 +430,57 @@ void reverse_tarray_tstatus()
     tarray = tarray_new;
     tstatus = tstatus_new;
 
-    rebuild_tmap();
+    renumber_task_vertices(perm);
+    rebuild_task_index();
 }
 
+// Sorts tarray and tstatus by the given (predicted) cost of each task, the most expensive first.
+// Rebuilds the task index.
+void sort_tarray_tstatus_by_cost(const std::vector<double>& cost)
+{
+    assert(tcount > 0 && (int) cost.size() == tcount);
+    std::vector<int> order;
+
+    for (int i = 0; i < tcount; i++)
+    {
+        order.push_back(i);
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&cost](int a, int b) { return cost[a] > cost[b]; });
 
+    task *tarray_new = new task[tcount];
+    std::atomic<task_status> *tstatus_new = new std::atomic<task_status>[tcount];
+    for (int i = 0; i < tcount; i++)
+    {
+	tarray_new[i] = tarray[order[i]];
+	tstatus_new[i].store(tstatus[order[i]]);
+    }
 
-bool possible_task_advanced(adversary_vertex *v, int largest_item, int calldepth)
+    delete[] tarray;
+    delete[] tstatus;
+    tarray = tarray_new;
+    tstatus = tstatus_new;
+
+    std::vector<int> new_position(tcount);
+    for (int i = 0; i < tcount; i++)
+    {
+	new_position[order[i]] = i;
+    }
+    renumber_task_vertices(new_position);
+    rebuild_task_index();
+}
+
+bool possible_task_advanced(adversary_vertex *v, int largest_item, int calldepth, const task_bounds &bounds)
 {
     int target_depth = 0;
     if (largest_item >= S/4)
     {
-	target_depth = task_depth;
+	target_depth = bounds.depth;
     } else if (largest_item >= 3)
     {
-	target_depth = task_depth + 1;
+	target_depth = bounds.depth + 1;
     } else {
-	target_depth = task_depth + 3;
+	target_depth = bounds.depth + 3;
     }
 
     if (calldepth >= target_depth)
@@ -359,9 +500,9 @@ bool possible_task_size(adversary_vertex *v)
     return false;
 }
 
-bool possible_task_depth(adversary_vertex *v, int largest_item, int calldepth)
+bool possible_task_depth(adversary_vertex *v, int largest_item, int calldepth, const task_bounds &bounds)
 {
-    if (calldepth >= task_depth)
+    if (calldepth >= bounds.depth)
     {
 	return true;
     }
@@ -369,25 +510,25 @@ bool possible_task_depth(adversary_vertex *v, int largest_item, int calldepth)
     return false;
 }
 
-bool possible_task_mixed(adversary_vertex *v, int largest_item, int calldepth)
+bool possible_task_mixed(adversary_vertex *v, int largest_item, int calldepth, const task_bounds &bounds)
 {
 
-    if (v->bc.totalload() - computation_root->bc.totalload() >= task_load)
+    if (v->bc.totalload() - bounds.root_load >= bounds.load)
     {
 	if (TASK_DEBUG)
 	{
 	    fprintf(stderr, "Task selected because of load %d being at least %d: ",
-		    v->bc.totalload() - computation_root->bc.totalload(), task_load);
+		    v->bc.totalload() - bounds.root_load, bounds.load);
 	    v->print(stderr, true);
 	}
 	
 	return true;
-    } else if (calldepth >= task_depth)
+    } else if (calldepth >= bounds.depth)
     {
 	if (TASK_DEBUG)
 	{
 	    fprintf(stderr, "Task selected because of depth %d being at least %d: ",
-		    calldepth, task_depth);
+		    calldepth, bounds.depth);
 	    v->print(stderr, true);
 	}
 	
@@ -397,14 +538,14 @@ bool possible_task_mixed(adversary_vertex *v, int largest_item, int calldepth)
     }
 }
 
-bool possible_task_mixed2(adversary_vertex *v, int largest_item, int calldepth)
+bool possible_task_mixed2(adversary_vertex *v, int largest_item, int calldepth, const task_bounds &bounds)
 {
     if (largest_item >= S/2 && calldepth >= 2)
     {
 	return true;
     }
 
-    if (calldepth >= task_depth)
+    if (calldepth >= bounds.depth)
     {
 	return true;
     }
@@ -436,7 +577,8 @@ void collect_tasks_adv(adversary_vertex *v)
 	}
 
 	task newtask(v->bc);
-	tmap.insert(std::make_pair(newtask.bc.hash_with_last(), tarray_temporary.size()));
+	v->task_id = tarray_temporary.size();
+	task_vertices.push_back(v);
 	tarray_temporary.push_back(newtask);
 	tstatus_temporary.push_back(task_status::available);
 	tcount++;
@@ -472,26 +614,114 @@ void collect_tasks(adversary_vertex *r)
     collect_tasks_adv(r);
 }
 
+// Collects the tasks of several saplings into one task array. A task shared by
+// two saplings is collected only once.
+void collect_tasks(const std::vector<adversary_vertex*>& roots)
+{
+    qdag->clear_visited();
+    tcount = 0;
+    for (adversary_vertex *r : roots)
+    {
+	collect_tasks_adv(r);
+    }
+}
+
 void clear_task_structures()
 {
     tcount = 0;
     thead = 0;
     tstatus_temporary.clear();
     tarray_temporary.clear();
-    tmap.clear();
+    tindex.clear();
+    task_vertices.clear();
 }
 
+// Pruned tasks which the overseers have not been told about yet. Filled by the updater
+// thread and sent out periodically by the main thread of the queen.
+std::mutex pruned_pending_mutex;
+std::vector<int> pruned_pending;
+
+// The number of tasks removed so far; only touched by the updater thread.
+uint64_t removed_tasks = 0;
+
 // Does not actually remove a task, just marks it as completed.
 // Only run when UPDATING; in GENERATING you just mark a vertex as not a task.
-void remove_task(uint64_t hash)
+void remove_task(const adversary_vertex *v)
+{
+    int task_id = tstatus_id(v);
+    if (task_id == -1)
+    {
+	return;
+    }
+    tstatus[task_id].store(task_status::pruned, std::memory_order_release);
+    removed_tasks++;
+
+    if (PRUNED_PROPAGATION)
+    {
+	std::unique_lock<std::mutex> lk(pruned_pending_mutex);
+	pruned_pending.push_back(task_id);
+    }
+}
+
+// Takes all pruned tasks not yet sent out.
+std::vector<int> take_pruned_pending()
 {
-    tstatus[tmap[hash]].store(task_status::pruned, std::memory_order_release);
+    std::vector<int> ret;
+    std::unique_lock<std::mutex> lk(pruned_pending_mutex);
+    ret.swap(pruned_pending);
+    return ret;
+}
+
+// Finished tasks which the incremental updater has not processed yet. Filled by the main
+// thread of the queen and taken by the updater thread.
+std::mutex finished_pending_mutex;
+std::vector<int> finished_pending;
+
+std::vector<int> take_finished_pending()
+{
+    std::vector<int> ret;
+    std::unique_lock<std::mutex> lk(finished_pending_mutex);
+    ret.swap(finished_pending);
+    return ret;
+}
+
+// Queen: records the (task id, status) pairs reported by the overseers.
+void apply_solution_pairs(const int *solution_pairs, int count)
+{
+    for (int p = 0; p + 1 < count; p += 2)
+    {
+	// add it to the collected set of the queen
+	if (static_cast<task_status>(solution_pairs[p+1]) != task_status::irrelevant)
+	{
+	    if (tstatus[solution_pairs[p]].load(std::memory_order_acquire) == task_status::pruned)
+	    {
+		g_meas.pruned_collision++;
+	    }
+	    tstatus[solution_pairs[p]].store(static_cast<task_status>(solution_pairs[p+1]),
+					     std::memory_order_release);
+	    if (INCREMENTAL_UPDATER)
+	    {
+		std::unique_lock<std::mutex> lk(finished_pending_mutex);
+		finished_pending.push_back(solution_pairs[p]);
+	    }
+	}
+	// Count the solution only after storing it; the updater may reset the counter
+	// and start an update at any moment, and it must not miss the last solution.
+	qmemory::collected_now++;
+	qmemory::collected_cumulative++;
+    }
 }
 
 // Check if a given task is complete, return its value. 
-victory completion_check(uint64_t hash)
+victory completion_check(const adversary_vertex *v)
 {
-    task_status query = tstatus[tmap[hash]].load(std::memory_order_acquire);
+    int task_id = tstatus_id(v);
+    if (task_id == -1)
+    {
+	return victory::uncertain;
+    }
+
+    task_status query = tstatus[task_id].load(std::memory_order_acquire);
     if (query == task_status::adv_win)
     {
 	return victory::adv;
@@ -2,6 +2,9 @@
 #include <cstdlib>
 #include <cassert>
 #include <map>
+#include <queue>
+#include <set>
+#include <unordered_set>
 
 #include "common.hpp"
 #include "hash.hpp"
@@ -29,6 +32,12 @@
 // This in principle can slow things down, but it also can alleviate some
 // inconsistency issues in the DAG.
 
+// With INCREMENTAL_UPDATER, most updates are incremental instead: a finished task sets the value
+// of its vertex, and the value is propagated upwards along the incoming edges, re-evaluating
+// (and pruning) only the ancestors whose value may change. This relies on the values of all
+// decided vertices being stored, which is true after a full update; every FULL_UPDATE_PERIOD-th
+// update is therefore still a full one.
+
 class updater_computation
 {
 public:
@@ -40,6 +49,15 @@ public:
     uint64_t vertices_visited = 0;
     bool evaluation = false;
     bool expansion = false;
+
+    // Ids of the vertices of the sapling (reachable from job.root when the updater starts).
+    // Incremental updates do not propagate outside of it, just as full updates do not.
+    std::unordered_set<uint64_t> sapling_adv;
+    std::unordered_set<uint64_t> sapling_alg;
+    int updates_since_full = FULL_UPDATE_PERIOD; // The first update is a full one.
+    // Tasks counted as finished since the last full update. With several saplings in a round,
+    // a shared task may already be decided by the updater of another sapling.
+    std::unordered_set<int> counted_tasks;
     
     updater_computation(dag *graph, sapling job)
 	{
@@ -52,6 +70,13 @@ public:
 
 	    evaluation = job.evaluation;
 	    expansion = job.expansion;
+
+	    if (INCREMENTAL_UPDATER)
+	    {
+		collect_sapling_vertices();
+		// The first update is a full one, so the tasks finished so far need not be processed.
+		take_finished_pending();
+	    }
 	}
 
     // A reduced constructor, when we wish to only update from root.
@@ -67,13 +92,46 @@ public:
 
     victory update_adv(adversary_vertex *v);
     victory update_alg(algorithm_vertex *v); 
-    void update()
-	{
+    victory reevaluate_adv(adversary_vertex *v);
+    victory reevaluate_alg(algorithm_vertex *v);
+    void update_incremental(const std::vector<int>& finished_task_ids);
 
-	    unfinished_tasks = 0;
-	    vertices_visited = 0;
+    void collect_sapling_vertices()
+	{
 	    d->clear_visited();
-	    update_adv(job.root);
+	    d->mark_reachable(job.root);
+	    for (const auto& [id, adv_v] : d->adv_by_id)
+	    {
+		if (adv_v->visited)
+		{
+		    sapling_adv.insert(id);
+		}
+	    }
+
+	    for (const auto& [id, alg_v] : d->alg_by_id)
+	    {
+		if (alg_v->visited)
+		{
+		    sapling_alg.insert(id);
+		}
+	    }
+	}
+
+    void update()
+	{
+	    // A pass may count a task as unfinished and only later remove it. The overseers
+	    // never report a removed task, so we repeat the pass until the count is exact;
+	    // otherwise the updater could wait forever for the last solutions.
+	    uint64_t removed_before = 0;
+	    counted_tasks.clear();
+	    do
+	    {
+		removed_before = removed_tasks;
+		unfinished_tasks = 0;
+		vertices_visited = 0;
+		d->clear_visited();
+		update_adv(job.root);
+	    } while (removed_tasks != removed_before && unfinished_tasks > 0);
 	    root_result = d->root->win;
 	    updater_result = job.root->win;
 	}
@@ -137,8 +195,7 @@ victory updater_computation::update_adv(adversary_vertex *v)
 
     if (v->task)
     {
-	uint64_t hash = v->bc.hash_with_last();
-	result = completion_check(hash);
+	result = completion_check(v);
 	if (result == victory::uncertain)
 	{
 	    unfinished_tasks++;
@@ -284,4 +341,228 @@ victory updater_computation::update_alg(algorithm_vertex *v)
     return result;
 }
 
+// Re-evaluates a vertex from the stored values of its children, without recursion.
+// The edge removals are the same as in update_adv().
+victory updater_computation::reevaluate_adv(adversary_vertex *v)
+{
+    victory result = victory::alg;
+    int right_move = 0;
+
+    std::list<adv_outedge*>::iterator it = v->out.begin();
+    while (it != v->out.end())
+    {
+	victory below = (*it)->to->win;
+	if (below == victory::adv)
+	{
+	    result = victory::adv;
+	    right_move = (*it)->item;
+	    break;
+	} else if (below == victory::alg)
+	{
+	    adv_outedge *removed_edge = (*it);
+	    qdag->remove_inedge<minimax::updating>(*it);
+	    qdag->del_adv_outedge(removed_edge);
+	    it = v->out.erase(it); // serves as it++
+	} else
+	{
+	    result = victory::uncertain;
+	    it++;
+	}
+    }
+
+    if (result == victory::adv)
+    {
+	qdag->remove_outedges_except<minimax::updating>(v, right_move);
+    }
+
+    if (result == victory::adv || result == victory::alg)
+    {
+	v->win = result;
+    }
+
+    return result;
+}
+
+victory updater_computation::reevaluate_alg(algorithm_vertex *v)
+{
+    victory result = victory::adv;
+    for (alg_outedge *e : v->out)
+    {
+	victory below = e->to->win;
+	if (below == victory::alg)
+	{
+	    result = victory::alg;
+	    break;
+	} else if (below == victory::uncertain)
+	{
+	    result = victory::uncertain;
+	}
+    }
+
+    if (result == victory::alg && v->state != vert_state::fixed)
+    {
+	qdag->remove_outedges<minimax::updating>(v);
+    }
+
+    if (result == victory::adv || result == victory::alg)
+    {
+	v->win = result;
+    }
+
+    return result;
+}
+
+// Processes the given finished tasks and propagates their values upwards.
+// Vertices are queued by their ids, as pruning may delete them before they are processed.
+void updater_computation::update_incremental(const std::vector<int>& finished_task_ids)
+{
+    if (updates_since_full >= FULL_UPDATE_PERIOD)
+    {
+	update();
+	updates_since_full = 0;
+	return;
+    }
+
+    updates_since_full++;
+    vertices_visited = 0;
+    uint64_t removed_before = removed_tasks;
+
+    // Pairs (is an adversary vertex, id) of the vertices whose value has just been decided.
+    std::queue<std::pair<bool, uint64_t>> decided;
+
+    for (int task_id : finished_task_ids)
+    {
+	uint64_t hash = tarray[task_id].bc.hash_with_last();
+	auto it = d->adv_by_hash.find(hash);
+	if (it == d->adv_by_hash.end())
+	{
+	    continue; // Pruned in the meantime.
+	}
+
+	adversary_vertex *v = it->second;
+	if (!v->task || sapling_adv.count(v->id) == 0 || counted_tasks.count(task_id) > 0)
+	{
+	    continue;
+	}
+
+	victory result = v->win;
+	if (result == victory::uncertain)
+	{
+	    result = completion_check(v);
+	}
+
+	if (result != victory::uncertain)
+	{
+	    v->win = result;
+	    counted_tasks.insert(task_id);
+	    vertices_visited++;
+	    if (unfinished_tasks > 0)
+	    {
+		unfinished_tasks--;
+	    }
+	    decided.push(std::make_pair(true, v->id));
+	}
+    }
+
+    // Vertices decided by the updater of another sapling are passed through, so that
+    // the propagation continues to the vertices of this sapling above them.
+    std::set<std::pair<bool, uint64_t>> passed;
+    std::vector<uint64_t> parents;
+    while (!decided.empty())
+    {
+	auto [adversary, id] = decided.front();
+	decided.pop();
+	parents.clear();
+
+	if (adversary)
+	{
+	    auto it = d->adv_by_id.find(id);
+	    if (it == d->adv_by_id.end())
+	    {
+		continue;
+	    }
+
+	    for (alg_outedge *e : it->second->in)
+	    {
+		parents.push_back(e->from->id);
+	    }
+
+	    for (uint64_t parent_id : parents)
+	    {
+		auto pit = d->alg_by_id.find(parent_id);
+		if (pit == d->alg_by_id.end() || sapling_alg.count(parent_id) == 0)
+		{
+		    continue;
+		}
+
+		algorithm_vertex *parent = pit->second;
+		if (parent->win != victory::uncertain || parent->state == vert_state::finished)
+		{
+		    if (parent->win != victory::uncertain && passed.insert(std::make_pair(false, parent_id)).second)
+		    {
+			decided.push(std::make_pair(false, parent_id));
+		    }
+		    continue;
+		}
+
+		vertices_visited++;
+		if (reevaluate_alg(parent) != victory::uncertain)
+		{
+		    decided.push(std::make_pair(false, parent_id));
+		}
+	    }
+	} else
+	{
+	    auto it = d->alg_by_id.find(id);
+	    if (it == d->alg_by_id.end())
+	    {
+		continue;
+	    }
+
+	    for (adv_outedge *e : it->second->in)
+	    {
+		parents.push_back(e->from->id);
+	    }
+
+	    for (uint64_t parent_id : parents)
+	    {
+		auto pit = d->adv_by_id.find(parent_id);
+		if (pit == d->adv_by_id.end() || sapling_adv.count(parent_id) == 0)
+		{
+		    continue;
+		}
+
+		adversary_vertex *parent = pit->second;
+		if (parent->win != victory::uncertain || parent->task || parent->leaf != leaf_type::nonleaf)
+		{
+		    if (parent->win != victory::uncertain && passed.insert(std::make_pair(true, parent_id)).second)
+		    {
+			decided.push(std::make_pair(true, parent_id));
+		    }
+		    continue;
+		}
+
+		vertices_visited++;
+		if (reevaluate_adv(parent) != victory::uncertain)
+		{
+		    decided.push(std::make_pair(true, parent_id));
+		}
+	    }
+	}
+    }
+
+    // Tasks pruned during the propagation will never be reported.
+    uint64_t removed_now = removed_tasks - removed_before;
+    unfinished_tasks = (unfinished_tasks > removed_now) ? unfinished_tasks - removed_now : 0;
+    root_result = d->root->win;
+    updater_result = job.root->win;
+
+    // Only a full update may confirm that the sapling is finished.
+    if (unfinished_tasks == 0 || updater_result != victory::uncertain)
+    {
+	update();
+	updates_since_full = 0;
+    }
+}
+
 #endif
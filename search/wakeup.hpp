@@ -0,0 +1,51 @@
+#ifndef _WAKEUP_HPP
+#define _WAKEUP_HPP 1
+
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "common.hpp"
+
+// A wakeup signal between threads of one process. A waiting thread sleeps until
+// another thread calls notify() or until the timeout (normally TICK_SLEEP) passes;
+// the timeout is only a fallback for events which are not signalled, such as MPI messages.
+
+// To avoid losing a notification which arrives between checking a condition and
+// going to sleep, read epoch() before checking the condition and pass it to wait_since().
+class wakeup_event
+{
+public:
+    std::mutex m;
+    std::condition_variable cv;
+    uint64_t counter = 0;
+
+    uint64_t epoch()
+	{
+	    std::unique_lock<std::mutex> lk(m);
+	    return counter;
+	}
+
+    void notify()
+	{
+	    {
+		std::unique_lock<std::mutex> lk(m);
+		counter++;
+	    }
+	    cv.notify_all();
+	}
+
+    // Sleeps until a notification newer than the given epoch, or until the timeout.
+    void wait_since(uint64_t since, int timeout_ms = TICK_SLEEP)
+	{
+	    std::unique_lock<std::mutex> lk(m);
+	    cv.wait_for(lk, std::chrono::milliseconds(timeout_ms), [&] { return counter != since; });
+	}
+
+    void wait(int timeout_ms = TICK_SLEEP)
+	{
+	    wait_since(epoch(), timeout_ms);
+	}
+};
+
+#endif // _WAKEUP_HPP
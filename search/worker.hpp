@@ -10,11 +10,12 @@
 #include "thread_attr.hpp"
 #include "minimax/computation.hpp"
 #include "tasks.hpp"
+#include "task_cost.hpp"
 #include "minimax/recursion.hpp"
+#include "minimax/dfpn.hpp"
 
 std::mutex worker_needed;
 std::condition_variable worker_needed_cv;
-std::shared_mutex batchpointer_mutex;
 
 class worker
 {
@@ -23,6 +24,9 @@ public:
     int tid; // thread id
     measure_attr measurements;
 
+    // The computation context, allocated once by the worker thread and reused for all its tasks.
+    computation<minimax::exploring, MINIBS_SCALE_WORKER> *comp = nullptr;
+
     worker_flags *flags = nullptr; // A pointer used for overseer-worker communication.
     
     int get_task();
@@ -1,5 +1,8 @@
 #ifndef _WORKER_METHODS_HPP
 #define _WORKER_METHODS_HPP 1
+
+#include <limits>
+
 #include "worker.hpp"
 #include "overseer.hpp"
 #include "exceptions.hpp"
@@ -11,43 +14,28 @@
 // Receives a new task (in this case, from the batch). Must be thread-safe.
 int worker::get_task()
 {
-    int assigned_index = 0;
     int assigned_tid = NO_MORE_TASKS;
-    std::shared_lock<std::shared_mutex> lk(batchpointer_mutex);
-    lk.unlock();
 
     while (true)
     {
+	uint64_t task_epoch = ov->task_event.epoch();
 	if (flags != nullptr && flags->root_solved)
 	{
 	    return -2; // Should be irrelevant, we check for root_solved immediately afterwards.
 	}
 
-	// In order to minimize useless atomic adding, check first.
-	if (ov->next_task.load() >= ov->tasks.size())
+	// Wait for the overseer to receive more tasks.
+	if (!ov->tasks.pop(assigned_tid))
 	{
-	    std::this_thread::sleep_for(std::chrono::milliseconds(TICK_SLEEP));
+	    ov->task_event.wait_since(task_epoch);
 	    continue;
 	}
+	// print_if<true>("Worker %d was assigned task %d.\n", thread_rank + tid, assigned_tid);
 
-	// Atomically get an index (naturally, it may again be greater than BATCH_SIZE).
-	lk.lock();
-	assigned_index = ov->next_task++; // atomic ++, so can be done in shared mode
-	int subjective_tasksize = ov->tasks.size();
-	if (assigned_index < subjective_tasksize)
-	{
-	    assigned_tid = ov->tasks[assigned_index];
-	}
-	lk.unlock();
-	// print_if<true>("Worker %d was assigned batch index %d.\n", thread_rank + tid, assigned_index);
+	// The overseer may now be running low on tasks.
+	ov->overseer_event.notify();
 
-	// actively wait for tasks
-	// TODO: make this into a passive
-	if (assigned_index >= subjective_tasksize)
-	{
-	    std::this_thread::sleep_for(std::chrono::milliseconds(TICK_SLEEP));
-	    continue;
-	} else if (assigned_tid == NO_MORE_TASKS)
+	if (assigned_tid == NO_MORE_TASKS)
 	{
 	    return NO_MORE_TASKS;
 	} else if (tstatus[assigned_tid].load() == task_status::pruned)
@@ -64,26 +52,21 @@ victory worker::solve(const task *t, const int& task_id)
 {
     victory ret = victory::uncertain;
 
-    computation<minimax::exploring, MINIBS_SCALE_WORKER> comp;
-
-    if (FURTHER_MEASURE)
-    {
-	dlog = new debug_logger(tid);
-    }
+    comp->reset(task_id);
  
     //tat.last_item = t->last_item;
-    comp.flags = this->flags;
-    comp.task_id = task_id;
+    comp->flags = this->flags;
     computation_root = NULL; // we do not run GENERATE or EXPAND on the workers currently
 
+    // The overseer allocates the minibinstretching cache anew each round.
     if (USING_HEURISTIC_WEIGHTSUM)
     {
-	comp.weight_heurs = ov->weight_heurs;
+	comp->weight_heurs = ov->weight_heurs;
     }
 
     if (USING_MINIBINSTRETCHING)
     {
-	comp.mbs = ov->mbs;
+	comp->mbs = ov->mbs;
     }
     
     // We create a copy of the sapling's bin configuration
@@ -93,20 +76,21 @@ victory worker::solve(const task *t, const int& task_id)
     // we do not pass last item information from the queen to the workers,
     // so we just behave as if last item was 1.
 
-    // worker depth is now set to be permanently zero
-    comp.prev_max_feasible = S;
-
     try
     {
-	ret = explore(&task_copy, &comp);
-	measurements.add(comp.meas);
+	if (USING_DFPN)
+	{
+	    ret = explore_dfpn(&task_copy, comp);
+	} else
+	{
+	    ret = explore(&task_copy, comp);
+	}
     } catch (computation_irrelevant &e)
     {
 	print_if<PROGRESS>("Worked %d: finishing computation, it is irrelevant.\n", thread_rank + tid);
 	ret = victory::irrelevant;
     }
 
-    delete dlog;
     assert(ret != victory::uncertain); // Might be victory for alg, adv or irrelevant.
     return ret;
 }
@@ -126,6 +110,15 @@ void worker::start(worker_flags *assigned_flags)
 
 
     int current_task_id;
+
+    // The computation context and the debug logger live as long as the worker thread.
+    comp = new computation<minimax::exploring, MINIBS_SCALE_WORKER>();
+
+    if (FURTHER_MEASURE)
+    {
+	dlog = new debug_logger(tid);
+    }
+
     std::unique_lock<std::mutex> lk(worker_needed);
     lk.unlock();
 
@@ -133,16 +126,23 @@ void worker::start(worker_flags *assigned_flags)
     {
 	// Wait until notified by overseer.
 	waiting.store(true);
+	ov->overseer_event.notify();
 	lk.lock();
 	worker_needed_cv.wait(lk);
 	lk.unlock();
 	waiting.store(false);
+	ov->overseer_event.notify();
 
 	print_if<DEBUG>("Worker %d (%d) waking up frow sleep.\n");
 
 	if (ov->final_round)
 	{
 	    print_if<DEBUG>("Worker %d (%d) terminating, final round.\n");
+	    measurements.add(comp->meas);
+	    delete comp;
+	    comp = nullptr;
+	    delete dlog;
+	    dlog = nullptr;
 	    return;
 	}
 
@@ -173,7 +173,7 @@ void worker::start(worker_flags *assigned_flags)
 	    current_task = tarray[current_task_id];
 	    // current_task.bc.hash_loads_init(); // should not be necessary
 
-	    if (TASKLOG)
+	    if (TASKLOG || TASK_COST_ORDERING)
 	    {
 		processing_start = std::chrono::system_clock::now();
 	    }
@@ -188,15 +188,20 @@ void worker::start(worker_flags *assigned_flags)
 	    }
 	    // note: solution may still be irrelevant if a signal came mid-computation
 
-	    if (TASKLOG)
+	    if (TASKLOG || TASK_COST_ORDERING)
 	    {
 		processing_end = std::chrono::system_clock::now();
 		std::chrono::duration<long double> processing_time = processing_end - processing_start;
-		if (processing_time.count() >= TASKLOG_THRESHOLD)
+		if (TASKLOG && processing_time.count() >= TASKLOG_THRESHOLD)
 		{
 		    fprintf(stderr, "%Lfs: ", processing_time.count());
 		    print_binconf_stream(stderr, &(current_task.bc));
 		}
+
+		// Only the solved tasks are reported, with the time stored before the task id
+		// is pushed to the overseer.
+		std::chrono::duration<long double, std::milli> milliseconds = processing_time;
+		ov->task_milliseconds[current_task_id] = (int) std::min(milliseconds.count(), (long double) std::numeric_limits<int>::max());
 	    }
 
 	    assert(solution == victory::alg || solution == victory::adv || solution == victory::irrelevant);
@@ -204,11 +209,15 @@ void worker::start(worker_flags *assigned_flags)
 	    if (solution == victory::adv)
 	    {
 		tstatus[current_task_id].store(task_status::adv_win);
-		ov->finished_tasks[tid].push(current_task_id);
+		bool reported = ov->finished_tasks.push(current_task_id);
+		assert(reported);
+		ov->overseer_event.notify();
 	    } else if (solution == victory::alg)
 	    {
 		tstatus[current_task_id].store(task_status::alg_win);
-		ov->finished_tasks[tid].push(current_task_id);
+		bool reported = ov->finished_tasks.push(current_task_id);
+		assert(reported);
+		ov->overseer_event.notify();
 	    }
 	}
 
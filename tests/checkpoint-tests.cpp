@@ -0,0 +1,253 @@
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+
+// Set constants for testing which are usually set at build time by the user.
+#define IBINS 3
+#define IR 19
+#define IS 14
+
+#include "../search/common.hpp"
+#include "../search/hash.hpp"
+#include "../search/binconf.hpp"
+#include "../search/dag/dag.hpp"
+#include "../search/tasks.hpp"
+#include "../search/checkpoint.hpp"
+#include "test_helpers.hpp"
+
+// Saves a DAG and the solved tasks of a round into a checkpoint, loads them back
+// and compares them with the originals. Also checks that truncated files are rejected.
+
+// Generates the first two moves of the adversary, with all items and all bins,
+// and sets the flags of the vertices to various values.
+dag* generate_dag()
+{
+    dag *d = new dag;
+    binconf empty;
+    empty.blank();
+    d->add_root(empty);
+
+    std::vector<adversary_vertex*> level(1, d->root);
+    for (int depth = 0; depth < 2; depth++)
+    {
+	std::vector<adversary_vertex*> next_level;
+	for (adversary_vertex *adv_v : level)
+	{
+	    for (int item = 1; item <= S; item++)
+	    {
+		algorithm_vertex *alg_v = d->add_alg_vertex(adv_v->bc, item, "opt " + std::to_string(item));
+		d->add_adv_outedge(adv_v, alg_v, item);
+		for (int bin = 1; bin <= BINS; bin++)
+		{
+		    if (adv_v->bc.loads[bin] + item >= R || (bin > 1 && adv_v->bc.loads[bin] == adv_v->bc.loads[bin-1]))
+		    {
+			continue;
+		    }
+
+		    binconf child = adv_v->bc;
+		    child.assign_and_rehash(item, bin);
+		    // Different paths lead to the same configuration, which makes it a DAG.
+		    auto it = d->adv_by_hash.find(child.hash_with_last());
+		    adversary_vertex *child_v = nullptr;
+		    if (it != d->adv_by_hash.end())
+		    {
+			child_v = it->second;
+		    } else
+		    {
+			child_v = d->add_adv_vertex(child);
+			next_level.push_back(child_v);
+		    }
+		    d->add_alg_outedge(alg_v, child_v, bin);
+		}
+	    }
+	}
+	level = next_level;
+    }
+
+    int counter = 0;
+    for (auto& [id, v] : d->adv_by_id)
+    {
+	v->win = static_cast<victory>(counter % 3);
+	v->state = static_cast<vert_state>(counter % 5);
+	v->leaf = static_cast<leaf_type>(counter % 5);
+	v->sapling = (counter % 7 == 0);
+	v->expansion_depth = counter % 4;
+	v->regrow_level = counter % 6;
+	counter++;
+    }
+    for (auto& [id, v] : d->alg_by_id)
+    {
+	v->win = static_cast<victory>(counter % 3);
+	v->state = static_cast<vert_state>(counter % 5);
+	v->leaf = static_cast<leaf_type>(counter % 5);
+	counter++;
+    }
+    return d;
+}
+
+// The vertices get new ids when loaded, so they are matched by their hashes.
+void compare_dags(dag *d, dag *l)
+{
+    check(d->adv_by_id.size() == l->adv_by_id.size(), "the number of adversary vertices matches");
+    check(d->alg_by_id.size() == l->alg_by_id.size(), "the number of algorithm vertices matches");
+    check(l->root != nullptr && l->root->bc.hash_with_last() == d->root->bc.hash_with_last(), "the root matches");
+
+    for (const auto& [hash, v] : d->adv_by_hash)
+    {
+	auto it = l->adv_by_hash.find(hash);
+	check(it != l->adv_by_hash.end(), "every adversary vertex is loaded");
+	adversary_vertex *w = it->second;
+	check(binconf_equal(&(v->bc), &(w->bc)) && v->bc.last_item == w->bc.last_item, "the configurations match");
+	check(v->win == w->win && v->state == w->state && v->leaf == w->leaf, "the win, state and leaf flags match");
+	check(v->sapling == w->sapling && v->expansion_depth == w->expansion_depth && v->regrow_level == w->regrow_level,
+	      "the sapling flags match");
+
+	check(v->out.size() == w->out.size(), "the outdegrees of adversary vertices match");
+	auto wit = w->out.begin();
+	for (adv_outedge *e : v->out)
+	{
+	    check(e->item == (*wit)->item, "the edges of adversary vertices are in the same order");
+	    check(e->to->bc.alghash(e->to->next_item) == (*wit)->to->bc.alghash((*wit)->to->next_item),
+		  "the edges of adversary vertices lead to the same vertices");
+	    wit++;
+	}
+    }
+
+    for (const auto& [hash, v] : d->alg_by_hash)
+    {
+	auto it = l->alg_by_hash.find(hash);
+	check(it != l->alg_by_hash.end(), "every algorithm vertex is loaded");
+	algorithm_vertex *w = it->second;
+	check(v->next_item == w->next_item && v->optimal == w->optimal, "the next items and optimal packings match");
+	check(v->win == w->win && v->state == w->state && v->leaf == w->leaf, "the win, state and leaf flags match");
+
+	check(v->out.size() == w->out.size(), "the outdegrees of algorithm vertices match");
+	auto wit = w->out.begin();
+	for (alg_outedge *e : v->out)
+	{
+	    check(e->target_bin == (*wit)->target_bin, "the edges of algorithm vertices are in the same order");
+	    check(e->to->bc.hash_with_last() == (*wit)->to->bc.hash_with_last(),
+		  "the edges of algorithm vertices lead to the same vertices");
+	    wit++;
+	}
+    }
+}
+
+void dag_tests(checkpoint &cp)
+{
+    dag *d = generate_dag();
+    queen_counters counters;
+    counters.round = 7;
+    counters.winning_saplings = 3;
+    counters.evaluation = false;
+    counters.expansion = true;
+    cp.save_dag(d, counters);
+    check(cp.exists(), "cp.exists()");
+
+    queen_counters loaded_counters;
+    dag *l = cp.load_dag(loaded_counters);
+    check(l != nullptr, "the saved DAG can be loaded");
+    check(loaded_counters.round == 7 && loaded_counters.winning_saplings == 3
+	  && !loaded_counters.evaluation && loaded_counters.expansion, "the counters match");
+    compare_dags(d, l);
+    fprintf(stderr, "DAG with %zu + %zu vertices loaded back.\n", d->adv_by_id.size(), d->alg_by_id.size());
+
+    // Every proper prefix of the file is rejected.
+    std::string saved = std::string(cp.dag_file_path) + ".saved";
+    std::filesystem::copy_file(cp.dag_file_path, saved, std::filesystem::copy_options::overwrite_existing);
+    uintmax_t size = std::filesystem::file_size(saved);
+    for (uintmax_t length = 0; length < size; length += 1 + length / 3)
+    {
+	std::filesystem::copy_file(saved, cp.dag_file_path, std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::resize_file(cp.dag_file_path, length);
+	check(cp.load_dag(loaded_counters) == nullptr, "a truncated DAG file is rejected");
+    }
+    std::filesystem::copy_file(saved, cp.dag_file_path, std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::resize_file(cp.dag_file_path, size - 1);
+    check(cp.load_dag(loaded_counters) == nullptr, "a DAG file without its last byte is rejected");
+    std::filesystem::remove(saved);
+
+    l->free_vertices();
+    delete l;
+    d->free_vertices();
+    delete d;
+}
+
+void solution_tests(checkpoint &cp)
+{
+    // The tasks are the positions after two items in the first bin.
+    std::vector<task> tasks;
+    std::vector<task_status> statuses;
+    for (int first = 1; first <= S; first++)
+    {
+	for (int second = 1; second <= S && first + second < R; second++)
+	{
+	    binconf b;
+	    b.blank();
+	    b.assign_and_rehash(first, 1);
+	    b.assign_and_rehash(second, 1);
+	    tasks.push_back(task(b));
+	    statuses.push_back(static_cast<task_status>(tasks.size() % 6));
+	}
+    }
+    init_tarray(tasks);
+    init_tstatus(statuses);
+
+    cp.save_solutions(7);
+    cp.load_solutions();
+    check(cp.resumed_round == 7, "cp.resumed_round == 7");
+    uint64_t solved = 0;
+    for (int i = 0; i < tcount; i++)
+    {
+	bool is_solved = statuses[i] == task_status::adv_win || statuses[i] == task_status::alg_win;
+	auto it = cp.resumed_solutions.find(tarray[i].bc.hash_with_last());
+	check(is_solved == (it != cp.resumed_solutions.end()), "exactly the solved tasks are loaded");
+	check(!is_solved || it->second == statuses[i], "the loaded results match");
+	solved += is_solved ? 1 : 0;
+    }
+    check(cp.resumed_solutions.size() == solved, "cp.resumed_solutions.size() == solved");
+
+    // Applied in the resumed round only; the tasks are marked as solved again.
+    for (int i = 0; i < tcount; i++)
+    {
+	tstatus[i].store(task_status::available);
+    }
+    check(cp.apply_solutions(6) == 0, "cp.apply_solutions(6) == 0");
+    check(cp.apply_solutions(7) == (int) solved, "cp.apply_solutions(7) == solved");
+    for (int i = 0; i < tcount; i++)
+    {
+	bool is_solved = statuses[i] == task_status::adv_win || statuses[i] == task_status::alg_win;
+	check(tstatus[i].load() == (is_solved ? statuses[i] : task_status::available), "the applied results match");
+    }
+    fprintf(stderr, "%" PRIu64 " of %d solved tasks loaded back.\n", solved, tcount);
+
+    std::string saved = std::string(cp.tasks_file_path) + ".saved";
+    std::filesystem::copy_file(cp.tasks_file_path, saved, std::filesystem::copy_options::overwrite_existing);
+    uintmax_t size = std::filesystem::file_size(saved);
+    for (uintmax_t length = 0; length < size; length += 1 + length / 3)
+    {
+	std::filesystem::copy_file(saved, cp.tasks_file_path, std::filesystem::copy_options::overwrite_existing);
+	std::filesystem::resize_file(cp.tasks_file_path, length);
+	cp.load_solutions();
+	check(cp.resumed_solutions.empty() && cp.resumed_round == -1, "a truncated tasks file is rejected");
+    }
+    std::filesystem::remove(saved);
+
+    destroy_tarray();
+    destroy_tstatus();
+}
+
+int main(void)
+{
+    zobrist_init();
+    enter_scratch_directory("binstretch-checkpoint-tests");
+    checkpoint cp;
+
+    dag_tests(cp);
+    solution_tests(cp);
+
+    cp.remove();
+    fprintf(stderr, "Checkpoint tests passed.\n");
+    return 0;
+}
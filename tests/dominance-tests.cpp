@@ -0,0 +1,88 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Set constants for testing which are usually set at build time by the user.
+#define IBINS 3
+#define IR 45
+#define IS 33
+
+#include "../search/common.hpp"
+#include "../search/hash.hpp"
+#include "../search/binconf.hpp"
+#include "../search/cache/dominance.hpp"
+
+// Checks that the dominance cache never answers for a position it has not seen,
+// and that its answers agree with the results inserted into it. Each inserted hash
+// stands for a family of positions in which the adversary wins exactly with the lowest
+// sendable items up to some threshold, as the exact results of adv_cache would say.
+// The threshold is derived from the hash itself, and the random hashes of the misses
+// are distinct from the inserted ones with overwhelming probability.
+
+// A large table checks few bits if the stored bits overlap with the position.
+constexpr uint64_t LOGBYTES = 27; // 2^24 elements.
+constexpr int MISSES = 1 << 24;
+
+int threshold(uint64_t h)
+{
+    return (h >> 7) % (S+1);
+}
+
+int main(void)
+{
+    zobrist_init();
+    dominance_cache dc(LOGBYTES);
+
+    // Half of the table, so that many slots have neighbours.
+    std::vector<uint64_t> inserted;
+    for (uint64_t i = 0; i < dc.htsize / 2; i++)
+    {
+	uint64_t h = rand_64bit();
+	int low = 1 + rand() % S;
+	dc.insert(h, low, low <= threshold(h) ? victory::adv : victory::alg);
+	inserted.push_back(h);
+    }
+
+    uint64_t answered = 0;
+    for (uint64_t h : inserted)
+    {
+	int t = threshold(h);
+	for (int low = 1; low <= S; low++)
+	{
+	    victory win = dc.lookup(h, low);
+	    if ((win == victory::adv && low > t) || (win == victory::alg && low <= t))
+	    {
+		fprintf(stderr, "The dominance cache answers wrongly for hash %" PRIu64 " and lowest item %d.\n", h, low);
+		return -1;
+	    }
+	    answered += (win != victory::uncertain) ? 1 : 0;
+	}
+    }
+
+    if (answered == 0)
+    {
+	fprintf(stderr, "The dominance cache answered no query.\n");
+	return -1;
+    }
+
+    // A false match on an unseen hash would be a wrong result in the search.
+    uint64_t false_matches = 0;
+    for (int i = 0; i < MISSES; i++)
+    {
+	uint64_t h = rand_64bit();
+	if (dc.lookup(h, 1 + rand() % S) != victory::uncertain)
+	{
+	    false_matches++;
+	}
+    }
+
+    if (false_matches > 0)
+    {
+	fprintf(stderr, "The dominance cache answered %" PRIu64 " of %d queries on unseen hashes.\n", false_matches, MISSES);
+	return -1;
+    }
+
+    fprintf(stderr, "The dominance cache agrees on %" PRIu64 " answered queries and has no false match in %d misses.\n",
+	    answered, MISSES);
+    return 0;
+}
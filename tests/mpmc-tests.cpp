@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+#include "mpmc_queue.hpp"
+#include "test_helpers.hpp"
+
+// Global variables for the purposes of this test
+constexpr int PRODUCERS = 4;
+constexpr int CONSUMERS = 4;
+constexpr int ITEMS_PER_PRODUCER = 100000;
+
+// A small queue, so that the producers often find it full.
+mpmc_queue<int> q(64);
+std::atomic<int> producers_done{0};
+std::vector<std::atomic<int>> seen(PRODUCERS * ITEMS_PER_PRODUCER);
+
+void producer(int id)
+{
+    for (int i = 0; i < ITEMS_PER_PRODUCER; i++)
+    {
+	int item = id * ITEMS_PER_PRODUCER + i;
+	while (!q.push(item))
+	{
+	    std::this_thread::yield();
+	}
+    }
+    producers_done++;
+}
+
+void consumer()
+{
+    int item = 0;
+    while (true)
+    {
+	if (q.pop(item))
+	{
+	    seen[item]++;
+	} else if (producers_done.load() == PRODUCERS)
+	{
+	    // The producers are done; what is left in the queue is popped by someone.
+	    if (!q.pop(item))
+	    {
+		break;
+	    }
+	    seen[item]++;
+	} else
+	{
+	    std::this_thread::yield();
+	}
+    }
+}
+
+void single_thread_tests()
+{
+    mpmc_queue<int> small(5);
+    check(small.capacity() == 8, "small.capacity() == 8");
+    check(small.empty(), "small.empty()");
+
+    for (int i = 0; i < 8; i++)
+    {
+	check(small.push(i), "small.push(i)");
+    }
+    check(!small.push(8), "!small.push(8)");
+    check(small.size() == 8, "small.size() == 8");
+
+    // First in, first out, also after the positions wrap around.
+    int item = -1;
+    for (int round = 0; round < 3; round++)
+    {
+	for (int i = 0; i < 8; i++)
+	{
+	    check(small.pop(item) && item == i, "small.pop(item) && item == i");
+	    check(small.push(i), "small.push(i)");
+	}
+    }
+
+    for (int i = 0; i < 8; i++)
+    {
+	check(small.pop(item) && item == i, "small.pop(item) && item == i");
+    }
+    check(!small.pop(item), "!small.pop(item)");
+
+    small.clear();
+    check(small.capacity() == 0, "small.capacity() == 0");
+    small.init(100);
+    check(small.capacity() == 128 && small.empty(), "small.capacity() == 128 && small.empty()");
+    fprintf(stderr, "Single thread tests passed.\n");
+}
+
+int main(void)
+{
+    single_thread_tests();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < PRODUCERS; i++)
+    {
+	threads.emplace_back(&producer, i);
+    }
+
+    for (int i = 0; i < CONSUMERS; i++)
+    {
+	threads.emplace_back(&consumer);
+    }
+
+    for (std::thread &t : threads)
+    {
+	t.join();
+    }
+
+    // Every item has been popped exactly once.
+    for (int i = 0; i < PRODUCERS * ITEMS_PER_PRODUCER; i++)
+    {
+	if (seen[i].load() != 1)
+	{
+	    fprintf(stderr, "Item %d was popped %d times.\n", i, seen[i].load());
+	    return -1;
+	}
+    }
+
+    fprintf(stderr, "%d producers and %d consumers passed %d items through the queue.\n",
+	    PRODUCERS, CONSUMERS, PRODUCERS * ITEMS_PER_PRODUCER);
+    return 0;
+}
@@ -7,6 +7,7 @@
 #include <condition_variable>
 #include <chrono>
 #include <sstream>
+#include <array>
 
 #include "net/local/threadsafe_printer.hpp"
 #include "net/local/synchronizer.hpp"
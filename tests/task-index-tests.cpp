@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_set>
+#include <vector>
+
+// Set constants for testing which are usually set at build time by the user.
+#define IBINS 3
+#define IR 19
+#define IS 14
+
+#include "../search/common.hpp"
+#include "../search/hash.hpp"
+#include "../search/binconf.hpp"
+#include "../search/tasks.hpp"
+#include "test_helpers.hpp"
+
+// Tests the open-addressing index from task hashes to task ids (task_index in tasks.hpp).
+// The tasks are picked by the lowest bits of their hashes, so that they collide
+// in the same slots and the linear probing wraps around the end of the table.
+
+// All positions with up to three items, each placed into every bin.
+std::vector<task> task_pool()
+{
+    std::vector<task> pool;
+    for (int first = 1; first <= S; first++)
+    {
+	for (int second = 0; second <= S; second++)
+	{
+	    for (int third = 0; third <= S; third++)
+	    {
+		for (int bin = 1; bin <= BINS; bin++)
+		{
+		    binconf b;
+		    b.blank();
+		    b.assign_and_rehash(first, 1);
+		    if (second > 0)
+		    {
+			b.assign_and_rehash(second, bin);
+		    }
+		    if (third > 0)
+		    {
+			b.assign_and_rehash(third, BINS);
+		    }
+		    pool.push_back(task(b));
+		}
+	    }
+	}
+    }
+    return pool;
+}
+
+// Picks tasks of distinct hashes whose lowest bits (given by mask) are equal to slot.
+std::vector<task> pick(const std::vector<task> &pool, uint64_t mask, uint64_t slot, unsigned int count,
+		       std::unordered_set<uint64_t> &used)
+{
+    std::vector<task> ret;
+    for (const task &t : pool)
+    {
+	uint64_t hash = t.bc.hash_with_last();
+	if ((hash & mask) == slot && !used.contains(hash))
+	{
+	    used.insert(hash);
+	    ret.push_back(t);
+	    if (ret.size() == count)
+	    {
+		break;
+	    }
+	}
+    }
+    check(ret.size() == count, "the pool has enough tasks for the slot");
+    return ret;
+}
+
+void collision_tests(const std::vector<task> &pool)
+{
+    // Four tasks give a table of eight slots. Three of them hash into the last slot,
+    // so they occupy slots 7, 0 and 1; the fourth hashes into slot 0 and ends up in slot 2.
+    const uint64_t mask = 7;
+    std::unordered_set<uint64_t> used;
+    std::vector<task> tasks = pick(pool, mask, mask, 3, used);
+    std::vector<task> into_first = pick(pool, mask, 0, 1, used);
+    tasks.push_back(into_first[0]);
+    // Hashes which are not in the index, one in the chain of collisions and one in an empty slot.
+    task missing_in_chain = pick(pool, mask, mask, 1, used)[0];
+    task missing_alone = pick(pool, mask, 4, 1, used)[0];
+
+    task_index index;
+    index.build(tasks.data(), tasks.size());
+    const task_index &lookup = index;
+    for (unsigned int i = 0; i < tasks.size(); i++)
+    {
+	check(lookup.find(tasks[i].bc.hash_with_last()) == (int) i, "every colliding task is found");
+    }
+
+    // A miss walks the whole chain across the end of the table and changes nothing.
+    for (int repeat = 0; repeat < 2; repeat++)
+    {
+	check(lookup.find(missing_in_chain.bc.hash_with_last()) == -1, "a hash in a chain of collisions misses");
+	check(lookup.find(missing_alone.bc.hash_with_last()) == -1, "a hash in an empty slot misses");
+    }
+    for (unsigned int i = 0; i < tasks.size(); i++)
+    {
+	check(lookup.find(tasks[i].bc.hash_with_last()) == (int) i, "the misses did not change the index");
+    }
+
+    // A rebuild replaces the previous tasks.
+    index.build(into_first.data(), 1);
+    check(index.find(into_first[0].bc.hash_with_last()) == 0, "a single task is found");
+    check(index.find(tasks[0].bc.hash_with_last()) == -1, "the tasks of the previous build are gone");
+
+    index.clear();
+    check(index.find(tasks[0].bc.hash_with_last()) == -1, "a cleared index misses");
+    fprintf(stderr, "Collision tests passed.\n");
+}
+
+void full_tests(const std::vector<task> &pool)
+{
+    // All distinct tasks of the pool, in a table at most half full.
+    std::vector<task> tasks;
+    std::unordered_set<uint64_t> used;
+    for (const task &t : pool)
+    {
+	if (used.insert(t.bc.hash_with_last()).second)
+	{
+	    tasks.push_back(t);
+	}
+    }
+
+    task_index index;
+    check(index.find(tasks[0].bc.hash_with_last()) == -1, "an empty index misses");
+    index.build(tasks.data(), tasks.size());
+    for (unsigned int i = 0; i < tasks.size(); i++)
+    {
+	check(index.find(tasks[i].bc.hash_with_last()) == (int) i, "every task is found");
+    }
+
+    binconf absent;
+    absent.blank();
+    absent.assign_and_rehash(S, 1);
+    absent.assign_and_rehash(S, 2);
+    absent.assign_and_rehash(S, 3);
+    absent.assign_and_rehash(1, 1);
+    check(!used.contains(absent.hash_with_last()), "the absent task is not in the pool");
+    check(index.find(absent.hash_with_last()) == -1, "a task outside of the index misses");
+    fprintf(stderr, "All %zu tasks found in the index.\n", tasks.size());
+}
+
+int main(void)
+{
+    zobrist_init();
+    std::vector<task> pool = task_pool();
+    collision_tests(pool);
+    full_tests(pool);
+    return 0;
+}
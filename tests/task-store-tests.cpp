@@ -0,0 +1,147 @@
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+
+// Set constants for testing which are usually set at build time by the user.
+#define IBINS 3
+#define IR 19
+#define IS 14
+
+#include "../search/common.hpp"
+#include "../search/hash.hpp"
+#include "../search/binconf.hpp"
+#include "../search/filetools.hpp"
+#include "../search/tasks.hpp"
+#include "../search/task_store.hpp"
+#include "test_helpers.hpp"
+
+// Appends the solved tasks of two rounds to the file of the solved task store, reloads it
+// after each round and checks that an incomplete record at the end is skipped and cut off.
+// The file operations are called directly, as TASK_STORE_ON_DISK may be off.
+
+// The tasks of a round are the positions after two items in the first bin, with
+// the statuses cycling through all values. Different offsets give different results.
+void init_round(int offset)
+{
+    std::vector<task> tasks;
+    std::vector<task_status> statuses;
+    for (int first = 1; first <= S; first++)
+    {
+	for (int second = 1; second <= S && first + second < R; second++)
+	{
+	    binconf b;
+	    b.blank();
+	    b.assign_and_rehash(first, 1);
+	    b.assign_and_rehash(second, 1);
+	    tasks.push_back(task(b));
+	    statuses.push_back(static_cast<task_status>((tasks.size() + offset) % 6));
+	}
+    }
+    init_tarray(tasks);
+    init_tstatus(statuses);
+}
+
+void end_round()
+{
+    destroy_tarray();
+    destroy_tstatus();
+}
+
+bool same_results(const solved_task_store &a, const solved_task_store &b)
+{
+    return a.solved == b.solved;
+}
+
+int main(void)
+{
+    zobrist_init();
+    enter_scratch_directory("binstretch-task-store-tests");
+    solved_task_store store;
+
+    // A missing file is no error.
+    solved_task_store empty;
+    empty.read_file();
+    check(empty.solved.empty(), "empty.solved.empty()");
+
+    // The first round creates the file.
+    init_round(0);
+    store.record();
+    check(!store.solved.empty() && store.unsaved.size() == store.solved.size(), "all results of the first round are new");
+    store.append_to_file();
+    store.unsaved.clear();
+    end_round();
+
+    solved_task_store first;
+    first.read_file();
+    check(same_results(store, first), "the first round is loaded back");
+    fprintf(stderr, "%zu solved tasks of the first round loaded back.\n", first.solved.size());
+
+    // The second round solves some of the same tasks again; only the new ones are appended.
+    init_round(1);
+    size_t known = store.solved.size();
+    store.record();
+    check(store.unsaved.size() == store.solved.size() - known, "only the new results are unsaved");
+    check(store.solved.size() > known, "the second round has new results");
+    store.append_to_file();
+    store.unsaved.clear();
+
+    solved_task_store second;
+    second.read_file();
+    check(same_results(store, second), "both rounds are loaded back");
+
+    // The loaded results mark the tasks of a round as solved.
+    for (int i = 0; i < tcount; i++)
+    {
+	tstatus[i].store(task_status::available);
+    }
+    int applied = second.apply();
+    int solved_now = 0;
+    for (int i = 0; i < tcount; i++)
+    {
+	task_status status = tstatus[i].load();
+	check(status == task_status::available || status == second.solved[tarray[i].bc.hash_with_last()],
+	      "the applied results match");
+	solved_now += (status != task_status::available) ? 1 : 0;
+    }
+    check(applied == solved_now && applied > 0, "applied == solved_now && applied > 0");
+    end_round();
+
+    // An incomplete record, as if the queen died while appending, is skipped and cut off.
+    uintmax_t complete_size = std::filesystem::file_size(store.file_path);
+    FILE *f = fopen(store.file_path, "ab");
+    uint64_t partial_hash = 12345;
+    fwrite(&partial_hash, sizeof(uint64_t), 1, f);
+    fclose(f);
+
+    solved_task_store third;
+    third.read_file();
+    check(same_results(store, third), "the incomplete record is skipped");
+    check(std::filesystem::file_size(store.file_path) == complete_size, "the incomplete record is cut off");
+
+    // The records appended after the cut are read correctly.
+    init_round(2);
+    known = third.solved.size();
+    third.record();
+    third.append_to_file();
+    third.unsaved.clear();
+    end_round();
+
+    solved_task_store fourth;
+    fourth.read_file();
+    check(same_results(third, fourth), "the records after the cut are loaded back");
+    check(fourth.solved.size() > known, "fourth.solved.size() > known");
+
+    // A file of a different instance is ignored.
+    f = fopen(store.file_path, "wb");
+    int signature[5] = {BINS, R, S + 1, monotonicity, solved_task_store::VERSION};
+    fwrite(signature, sizeof(int), 5, f);
+    fclose(f);
+    solved_task_store foreign;
+    foreign.read_file();
+    check(foreign.solved.empty(), "foreign.solved.empty()");
+
+    std::filesystem::remove(store.file_path);
+    fprintf(stderr, "Task store tests passed, %zu solved tasks in the end.\n", fourth.solved.size());
+    return 0;
+}
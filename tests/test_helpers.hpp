@@ -0,0 +1,31 @@
+#ifndef _TEST_HELPERS_HPP
+#define _TEST_HELPERS_HPP 1
+
+// Helpers shared by the standalone tests in this directory.
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+// Like assert(), but also evaluated with NDEBUG, so the checked calls may have side effects.
+void check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+	fprintf(stderr, "Check failed: %s.\n", what);
+	exit(-1);
+    }
+}
+
+// Moves into an empty temporary directory with a ./cache/ subdirectory, so that the files
+// written by the tested code do not touch those of a real computation.
+void enter_scratch_directory(const std::string &test_name)
+{
+    std::filesystem::path scratch = std::filesystem::temp_directory_path() / test_name;
+    std::filesystem::remove_all(scratch);
+    std::filesystem::create_directories(scratch / "cache");
+    std::filesystem::current_path(scratch);
+}
+
+#endif // _TEST_HELPERS_HPP